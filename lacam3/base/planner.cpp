@@ -7,6 +7,7 @@ bool Planner::FLG_SWAP = true;
 bool Planner::FLG_STAR = true;
 bool Planner::FLG_MULTI_THREAD = true;
 int Planner::SCATTER_MARGIN = 10;
+int Planner::SCATTER_THREADS = 1;
 int Planner::PIBT_NUM = 10;
 bool Planner::FLG_REFINER = true;
 int Planner::REFINER_NUM = 4;
@@ -16,13 +17,13 @@ float Planner::RANDOM_INSERT_PROB2 = 0.01;
 bool Planner::FLG_RANDOM_INSERT_INIT_NODE = false;
 float Planner::RECURSIVE_RATE = 0.2;
 double Planner::RECURSIVE_TIME_LIMIT = 1000;
+int Planner::REFINER_NEIGHBOR = NB_RANDOM;
+bool Planner::FLG_REFINER_SCHEDULER = false;
 
 std::string Planner::MSG;
 int Planner::CHECKPOINTS_DURATION = 5000;
 constexpr int CHECKPOINTS_NIL = -1;
 
-constexpr auto TIME_ZERO = std::chrono::seconds(0);
-
 Planner::Planner(const Instance *_ins, int _verbose, const Deadline *_deadline,
                  int _seed, int _depth, DistTable *_D)
     : ins(_ins),
@@ -38,7 +39,12 @@ Planner::Planner(const Instance *_ins, int _verbose, const Deadline *_deadline,
       heuristic(new Heuristic(ins, D)),
       scatter(nullptr),
       seed_refiner(0),
-      refiner_pool(),
+      refiner_pool(nullptr),
+      incumbent(nullptr),
+      incumbent_cost(-1),
+      deadline_refiner(nullptr),
+      refiner_stats(),
+      refiner_scheduler(RECURSIVE_RATE > 0, RECURSIVE_RATE < 1.0),
       OPEN(),
       EXPLORED(),
       H_init(nullptr),
@@ -52,6 +58,8 @@ Planner::Planner(const Instance *_ins, int _verbose, const Deadline *_deadline,
 
 Planner::~Planner()
 {
+  if (refiner_pool != nullptr) delete refiner_pool;
+  if (deadline_refiner != nullptr) delete deadline_refiner;
   if (heuristic != nullptr) delete heuristic;
   if (scatter != nullptr) delete scatter;
   for (auto &pibt : pibts) delete pibt;
@@ -75,16 +83,14 @@ Solution Planner::solve()
     search_iter += 1;
     update_checkpoints();
 
-    // check pooled procedures
-    refiner_pool.remove_if([&](auto &proc) {
-      if ((proc).wait_for(TIME_ZERO) != std::future_status::ready) return false;
-      apply_new_solution(proc.get());
-      ++seed_refiner;
-      refiner_pool.emplace_back(std::async(std::launch::async,
-                                           &Planner::get_refined_plan, this,
-                                           backtrack(H_goal)));
-      return true;
-    });
+    // check finished refiners
+    if (refiner_pool != nullptr) {
+      auto result = RefinerResult();
+      while (refiner_pool->pop_finished(result)) {
+        apply_new_solution(result);
+        submit_refiner(get_incumbent());
+      }
+    }
 
     // do not pop here!
     auto H = OPEN.front();
@@ -152,7 +158,11 @@ Solution Planner::solve()
 
   // clear pooled operaitons
   bool is_optimal = OPEN.empty();
-  for (auto &proc : refiner_pool) apply_new_solution(proc.get());
+  if (refiner_pool != nullptr) {
+    refiner_pool->cancel();
+    auto result = RefinerResult();
+    while (refiner_pool->pop_finished(result)) apply_new_solution(result);
+  }
   if (is_optimal) OPEN.clear();
 
   // end processing
@@ -173,16 +183,30 @@ HNode *Planner::create_highlevel_node(const Config &Q, HNode *parent)
   return H_new;
 }
 
-void Planner::apply_new_solution(const Solution &plan)
+void Planner::apply_new_solution(const RefinerResult &result)
 {
-  if (plan.empty()) return;
+  if (result.plan == nullptr) return;  // failed refiner
+  auto &plan = *result.plan;
+  auto &base = *result.base;
   info(3, verbose, deadline, "incorporate new solution");
 
-  // forcibly insert configuration
-  HNode *H_from = EXPLORED[plan[0]];
+  // forcibly insert configurations that differ from the base
+  HNode *H_from = base.nodes[result.t_start];
   HNode *H_to = nullptr;
-  for (auto t = 1; t < plan.size(); ++t) {
-    auto &&Q = plan[t];
+  auto Q = Config();
+  auto is_changed_prev = false;
+  for (auto t = 1; t <= plan.T; ++t) {
+    const auto t_base = result.t_start + t;
+    if (plan.is_same_config(t, base, t_base)) {
+      // the base has the edge already unless coming back from a detour
+      H_to = base.nodes[t_base];
+      if (is_changed_prev) rewrite(H_from, H_to);
+      is_changed_prev = false;
+      H_from = H_to;
+      continue;
+    }
+    is_changed_prev = true;
+    plan.get_config(t, ins->G, Q);
     auto iter = EXPLORED.find(Q);
     if (iter != EXPLORED.end()) {
       // known
@@ -199,6 +223,20 @@ void Planner::apply_new_solution(const Solution &plan)
   }
 }
 
+SnapshotPtr Planner::get_incumbent()
+{
+  // rebuild only when the goal has been improved
+  if (incumbent == nullptr || incumbent->nodes.back() != H_goal ||
+      incumbent_cost != H_goal->g) {
+    auto nodes = HNodes();
+    for (auto H = H_goal; H != nullptr; H = H->parent) nodes.push_back(H);
+    std::reverse(nodes.begin(), nodes.end());
+    incumbent = std::make_shared<const Snapshot>(nodes);
+    incumbent_cost = H_goal->g;
+  }
+  return incumbent;
+}
+
 Solution Planner::backtrack(HNode *H)
 {
   std::vector<Config> plan;
@@ -298,7 +336,8 @@ void Planner::set_scatter()
                    ? INT_MAX
                    : (deadline->time_limit_ms - elapsed_ms(deadline)) / 2);
   auto margin = SCATTER_MARGIN < 0 ? get_random_int(MT, 0, 30) : SCATTER_MARGIN;
-  scatter = new Scatter(ins, D, &scatter_deadline, 3, verbose - 4, margin);
+  scatter = new Scatter(ins, D, &scatter_deadline, 3, verbose - 4, margin,
+                        FLG_MULTI_THREAD ? SCATTER_THREADS : 1);
   scatter->construct();
   info(1, verbose, deadline, "finish computing SUO",
        ", collision count: ", scatter->CT.collision_cnt,
@@ -317,45 +356,87 @@ void Planner::set_refiner()
 {
   if (!FLG_REFINER) return;
   if (!FLG_MULTI_THREAD) return;
-  auto plan = backtrack(H_goal);
+  auto plan = get_incumbent();
   info(2, verbose, deadline, "invoke refiners");
-  for (auto k = 0; k < REFINER_NUM; ++k) {
-    ++seed_refiner;
-    refiner_pool.emplace_back(
-        std::async(std::launch::async, &Planner::get_refined_plan, this, plan));
-  }
+  refiner_pool = new RefinerPool(REFINER_NUM);
+  deadline_refiner = new Deadline(deadline, &refiner_pool->flg_cancel);
+  for (auto k = 0; k < REFINER_NUM; ++k) submit_refiner(plan);
+}
+
+void Planner::submit_refiner(const SnapshotPtr &plan)
+{
+  ++seed_refiner;
+  refiner_pool->submit([this, plan, refiner_seed = seed_refiner] {
+    return get_refined_plan(plan, refiner_seed);
+  });
 }
 
-Solution Planner::get_refined_plan(const Solution &plan)
+RefinerResult Planner::get_refined_plan(const SnapshotPtr &plan,
+                                        const int refiner_seed)
 {
-  auto MT_internal = std::mt19937(seed_refiner);
-  if (depth < 1 && plan.size() > 3 &&
+  if (FLG_REFINER_SCHEDULER) {
+    return get_scheduled_refined_plan(plan, refiner_seed);
+  }
+  auto MT_internal = std::mt19937(refiner_seed);
+  if (depth < 1 && plan->T > 2 &&
       get_random_float(MT_internal) < RECURSIVE_RATE) {
     // recursive LaCAM
-    auto ins_tmp =
-        Instance(ins->G, plan[get_random_int(MT_internal, 1, plan.size() - 2)],
-                 ins->goals, N);
-    ins_tmp.delete_graph_after_used = false;
-    auto deadline_tmp = Deadline(std::min(
-        RECURSIVE_TIME_LIMIT,
-        deadline == nullptr ? INT_MAX
-                            : deadline->time_limit_ms - elapsed_ms(deadline)));
-    auto planner_tmp =
-        Planner(&ins_tmp, 0, &deadline_tmp, seed_refiner, depth + 1, D);
-    info(4, verbose, deadline, "refiner-", planner_tmp.seed,
+    const auto t = get_random_int(MT_internal, 1, plan->T - 1);
+    info(4, verbose, deadline_refiner, "refiner-", refiner_seed,
          "\tactivated (recursive LaCAM)");
-    auto res = planner_tmp.solve();
-    info(4, verbose, deadline, "refiner-", planner_tmp.seed,
+    auto res = refine_recursively(*this, *plan, t, refiner_seed);
+    info(4, verbose, deadline_refiner, "refiner-", refiner_seed,
          "\tcompleted (recursive LaCAM)");
-    return res;
+    return {plan, res, t};
   } else if (RECURSIVE_RATE < 1.0) {
     // iterative refinement
-    return refine(ins, deadline, plan, D, seed_refiner, verbose - 4);
+    return {plan,
+            refine(ins, deadline_refiner, *plan, D, refiner_seed, verbose - 4,
+                   REFINER_NEIGHBOR, &refiner_stats),
+            0};
   } else {
-    return Solution();
+    return {plan, nullptr, 0};
   }
 }
 
+RefinerResult Planner::get_scheduled_refined_plan(const SnapshotPtr &plan,
+                                                  const int refiner_seed)
+{
+  auto MT_internal = std::mt19937(refiner_seed);
+  const auto k =
+      refiner_scheduler.select(MT_internal, depth < 1 && plan->T > 2);
+  if (k == -1) return {plan, nullptr, 0};
+  const auto name = refiner_scheduler.get_name(k);
+  info(4, verbose, deadline_refiner, "refiner-", refiner_seed,
+       "\tscheduled: ", name);
+  const auto t_start = Time::now();
+  auto res = RefinerResult{plan, nullptr, 0};
+  auto gain = 0;
+  if (refiner_scheduler.arms[k].size == 0) {
+    // recursive LaCAM, from the middle of the plan
+    const auto t = get_random_int(MT_internal, 1, plan->T - 1);
+    res.plan = refine_recursively(*this, *plan, t, refiner_seed);
+    if (res.plan != nullptr) {
+      res.t_start = t;
+      gain = plan->get_sum_of_loss(t) - res.plan->get_sum_of_loss();
+    }
+  } else {
+    // iterative refinement
+    res.plan = refine(ins, deadline_refiner, *plan, D, refiner_seed,
+                      verbose - 4, REFINER_NEIGHBOR, &refiner_stats,
+                      refiner_scheduler.arms[k].size);
+    if (res.plan != nullptr) {
+      gain = plan->get_sum_of_loss() - res.plan->get_sum_of_loss();
+    }
+  }
+  const auto ms =
+      std::chrono::duration<double, std::milli>(Time::now() - t_start).count();
+  refiner_scheduler.update(k, std::max(gain, 0), ms);
+  info(4, verbose, deadline_refiner, "refiner-", refiner_seed,
+       "\tcompleted: ", name, ", gain: ", gain, ", ms: ", ms);
+  return res;
+}
+
 void Planner::update_checkpoints()
 {
   const auto time = elapsed_ms(deadline);
@@ -375,6 +456,24 @@ void Planner::logging()
   MSG += "\nsearch_iteration=" + std::to_string(search_iter);
   MSG += "\nnum_high_level_node=" + std::to_string(HNode::COUNT);
   MSG += "\nnum_low_level_node=" + std::to_string(LNode::COUNT);
+  MSG += "\nrefiner_neighbors=";
+  for (auto nb = 0; nb < NB_NUM; ++nb) {
+    // name:iterations:gain:ms
+    MSG += std::string(REFINER_NEIGHBOR_NAMES[nb]) + ":" +
+           std::to_string(refiner_stats.iter[nb]) + ":" +
+           std::to_string(refiner_stats.gain[nb]) + ":" +
+           std::to_string(int(refiner_stats.ms[nb])) + ",";
+  }
+  if (FLG_REFINER_SCHEDULER) {
+    MSG += "\nrefiner_arms=";
+    for (auto k = 0; k < (int)refiner_scheduler.arms.size(); ++k) {
+      // name:pulls:gain:ms
+      auto &arm = refiner_scheduler.arms[k];
+      MSG += refiner_scheduler.get_name(k) + ":" + std::to_string(arm.pulls) +
+             ":" + std::to_string(arm.gain) + ":" +
+             std::to_string(int(arm.ms)) + ",";
+    }
+  }
 
   if (H_goal != nullptr && OPEN.empty()) {
     info(1, verbose, deadline, "solved optimally, cost:", H_goal->g);
@@ -23,6 +23,7 @@
 #include "instance.hpp"
 #include "pibt.hpp"
 #include "refiner.hpp"
+#include "refiner_pool.hpp"
 #include "scatter.hpp"
 #include "translator.hpp"
 #include "utils.hpp"
@@ -52,7 +53,12 @@ struct Planner {
 
   // for refiner
   int seed_refiner;
-  std::list<std::future<Solution>> refiner_pool;
+  RefinerPool *refiner_pool;
+  SnapshotPtr incumbent;  // latest solution given to refiners
+  int incumbent_cost;
+  Deadline *deadline_refiner;  // cancelled when the search ends
+  RefinerStats refiner_stats;
+  RefinerScheduler refiner_scheduler;
 
   // for search utils
   std::deque<HNode *> OPEN;
@@ -66,6 +72,7 @@ struct Planner {
       FLG_STAR;  // whether to refine solutions after initial solution discovery
   static bool FLG_MULTI_THREAD;
   static int SCATTER_MARGIN;  // used in SUO
+  static int SCATTER_THREADS;  // number of threads used in SUO
   static int PIBT_NUM;  // number of PIBT run, i.e., Monte-Carlo configuration
                         // generator
   static bool FLG_REFINER;  // whether to use refiners
@@ -77,6 +84,8 @@ struct Planner {
   static bool FLG_RANDOM_INSERT_INIT_NODE;
   static float RECURSIVE_RATE;
   static double RECURSIVE_TIME_LIMIT;
+  static int REFINER_NEIGHBOR;  // neighborhood generator of refiners
+  static bool FLG_REFINER_SCHEDULER;  // whether to choose refiners adaptively
 
   // for logging
   static int CHECKPOINTS_DURATION;
@@ -99,11 +108,16 @@ struct Planner {
   void rewrite(HNode *H_from, HNode *H_to);
   int get_edge_cost(const Config &C1, const Config &C2);
   Solution backtrack(HNode *H);
-  void apply_new_solution(const Solution &plan);
+  void apply_new_solution(const RefinerResult &result);
+  SnapshotPtr get_incumbent();
   void set_scatter();
   void set_pibt();
   void set_refiner();
-  Solution get_refined_plan(const Solution &plan_origin);
+  void submit_refiner(const SnapshotPtr &plan);
+  RefinerResult get_refined_plan(const SnapshotPtr &plan,
+                                 const int refiner_seed);
+  RefinerResult get_scheduled_refined_plan(const SnapshotPtr &plan,
+                                           const int refiner_seed);
   void update_checkpoints();
   void logging();
 };
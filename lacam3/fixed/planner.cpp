@@ -7,6 +7,7 @@ bool Planner::FLG_SWAP = true;
 bool Planner::FLG_STAR = true;
 bool Planner::FLG_MULTI_THREAD = true;
 int Planner::SCATTER_MARGIN = 10;
+int Planner::SCATTER_THREADS = 1;
 int Planner::PIBT_NUM = 10;
 bool Planner::FLG_REFINER = true;
 int Planner::REFINER_NUM = 4;
@@ -16,6 +17,8 @@ float Planner::RANDOM_INSERT_PROB2 = 0.01;
 bool Planner::FLG_RANDOM_INSERT_INIT_NODE = false;
 float Planner::RECURSIVE_RATE = 0.2;
 double Planner::RECURSIVE_TIME_LIMIT = 1000;
+int Planner::REFINER_NEIGHBOR = NB_RANDOM;
+bool Planner::FLG_REFINER_SCHEDULER = false;
 
 std::string Planner::MSG;
 int Planner::CHECKPOINTS_DURATION = 5000;
@@ -39,6 +42,7 @@ Planner::Planner(const Instance *_ins, int _verbose, const Deadline *_deadline,
       scatter(nullptr),
       seed_refiner(0),
       refiner_pool(),
+      refiner_scheduler(RECURSIVE_RATE > 0, RECURSIVE_RATE < 1.0),
       OPEN(),
       EXPLORED(),
       H_init(nullptr),
@@ -293,7 +297,8 @@ void Planner::set_scatter()
                    ? INT_MAX
                    : (deadline->time_limit_ms - elapsed_ms(deadline)) / 2);
   auto margin = SCATTER_MARGIN < 0 ? get_random_int(MT, 0, 30) : SCATTER_MARGIN;
-  scatter = new Scatter(ins, D, &scatter_deadline, 3, verbose - 4, margin);
+  scatter = new Scatter(ins, D, &scatter_deadline, 3, verbose - 4, margin,
+                        FLG_MULTI_THREAD ? SCATTER_THREADS : 1);
   scatter->construct();
   info(1, verbose, deadline, "finish computing SUO",
        ", collision count: ", scatter->CT.collision_cnt,
@@ -323,34 +328,75 @@ void Planner::set_refiner()
 
 Solution Planner::get_refined_plan(const Solution &plan)
 {
+  if (FLG_REFINER_SCHEDULER) return get_scheduled_refined_plan(plan);
   auto MT_internal = std::mt19937(seed_refiner);
   if (depth < 1 && plan.size() > 3 &&
       get_random_float(MT_internal) < RECURSIVE_RATE) {
     // recursive LaCAM
-    auto ins_tmp =
-        Instance(ins->G, plan[get_random_int(MT_internal, 1, plan.size() - 2)],
-                 ins->goals, N);
-    ins_tmp.delete_graph_after_used = false;
-    auto deadline_tmp = Deadline(std::min(
-        RECURSIVE_TIME_LIMIT,
-        deadline == nullptr ? INT_MAX
-                            : deadline->time_limit_ms - elapsed_ms(deadline)));
-    auto planner_tmp =
-        Planner(&ins_tmp, 0, &deadline_tmp, seed_refiner, depth + 1, D);
-    info(4, verbose, deadline, "refiner-", planner_tmp.seed,
-         "\tactivated (recursive LaCAM)");
-    auto res = planner_tmp.solve();
-    info(4, verbose, deadline, "refiner-", planner_tmp.seed,
-         "\tcompleted (recursive LaCAM)");
-    return res;
+    const auto t = get_random_int(MT_internal, 1, plan.size() - 2);
+    return get_recursive_plan(plan, t, seed_refiner);
   } else if (RECURSIVE_RATE < 1.0) {
     // iterative refinement
-    return refine(ins, deadline, plan, D, seed_refiner, verbose - 4);
+    return refine(ins, deadline, plan, D, seed_refiner, verbose - 4,
+                  REFINER_NEIGHBOR);
   } else {
     return Solution();
   }
 }
 
+Solution Planner::get_scheduled_refined_plan(const Solution &plan)
+{
+  const auto refiner_seed = seed_refiner;
+  auto MT_internal = std::mt19937(refiner_seed);
+  const auto k =
+      refiner_scheduler.select(MT_internal, depth < 1 && plan.size() > 3);
+  if (k == -1) return Solution();
+  const auto name = refiner_scheduler.get_name(k);
+  info(4, verbose, deadline, "refiner-", refiner_seed, "\tscheduled: ", name);
+  const auto t_start = Time::now();
+  auto res = Solution();
+  auto gain = 0;
+  if (refiner_scheduler.arms[k].size == 0) {
+    // recursive LaCAM, from the middle of the plan
+    const auto t = get_random_int(MT_internal, 1, plan.size() - 2);
+    res = get_recursive_plan(plan, t, refiner_seed);
+    if (!res.empty()) {
+      gain = get_sum_of_loss(Solution(plan.begin() + t, plan.end())) -
+             get_sum_of_loss(res);
+    }
+  } else {
+    // iterative refinement
+    res = refine(ins, deadline, plan, D, refiner_seed, verbose - 4,
+                 REFINER_NEIGHBOR, nullptr, refiner_scheduler.arms[k].size);
+    if (!res.empty()) gain = get_sum_of_loss(plan) - get_sum_of_loss(res);
+  }
+  const auto ms =
+      std::chrono::duration<double, std::milli>(Time::now() - t_start).count();
+  refiner_scheduler.update(k, std::max(gain, 0), ms);
+  info(4, verbose, deadline, "refiner-", refiner_seed, "\tcompleted: ", name,
+       ", gain: ", gain, ", ms: ", ms);
+  return res;
+}
+
+Solution Planner::get_recursive_plan(const Solution &plan, const int t,
+                                     const int refiner_seed)
+{
+  auto ins_tmp = Instance(ins->G, plan[t], ins->goals, N);
+  ins_tmp.delete_graph_after_used = false;
+  auto deadline_tmp = Deadline(std::min(
+      RECURSIVE_TIME_LIMIT,
+      deadline == nullptr ? INT_MAX
+                          : deadline->time_limit_ms - elapsed_ms(deadline)));
+  auto planner_tmp =
+      Planner(&ins_tmp, 0, &deadline_tmp, refiner_seed, depth + 1, D);
+  info(4, verbose, deadline, "refiner-", planner_tmp.seed,
+       "\tactivated (recursive LaCAM)");
+  auto res = planner_tmp.solve();
+  info(4, verbose, deadline, "refiner-", planner_tmp.seed,
+       "\tcompleted (recursive LaCAM)");
+  return res;
+}
+
 void Planner::update_checkpoints()
 {
   const auto time = elapsed_ms(deadline);
@@ -370,6 +416,16 @@ void Planner::logging()
   MSG += "\nsearch_iteration=" + std::to_string(search_iter);
   MSG += "\nnum_high_level_node=" + std::to_string(HNode::COUNT);
   MSG += "\nnum_low_level_node=" + std::to_string(LNode::COUNT);
+  if (FLG_REFINER_SCHEDULER) {
+    MSG += "\nrefiner_arms=";
+    for (auto k = 0; k < (int)refiner_scheduler.arms.size(); ++k) {
+      // name:pulls:gain:ms
+      auto &arm = refiner_scheduler.arms[k];
+      MSG += refiner_scheduler.get_name(k) + ":" + std::to_string(arm.pulls) +
+             ":" + std::to_string(arm.gain) + ":" +
+             std::to_string(int(arm.ms)) + ",";
+    }
+  }
 
   if (H_goal != nullptr && OPEN.empty()) {
     info(1, verbose, deadline, "solved optimally, cost:", H_goal->g);
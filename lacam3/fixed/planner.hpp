@@ -53,6 +53,7 @@ struct Planner {
   // for refiner
   int seed_refiner;
   std::list<std::future<Solution>> refiner_pool;
+  RefinerScheduler refiner_scheduler;
 
   // for search utils
   std::deque<HNode *> OPEN;
@@ -66,6 +67,7 @@ struct Planner {
       FLG_STAR;  // whether to refine solutions after initial solution discovery
   static bool FLG_MULTI_THREAD;
   static int SCATTER_MARGIN;  // used in SUO
+  static int SCATTER_THREADS;  // number of threads used in SUO
   static int PIBT_NUM;  // number of PIBT run, i.e., Monte-Carlo configuration
                         // generator
   static bool FLG_REFINER;  // whether to use refiners
@@ -77,6 +79,8 @@ struct Planner {
   static bool FLG_RANDOM_INSERT_INIT_NODE;
   static float RECURSIVE_RATE;
   static double RECURSIVE_TIME_LIMIT;
+  static int REFINER_NEIGHBOR;  // neighborhood generator of refiners
+  static bool FLG_REFINER_SCHEDULER;  // whether to choose refiners adaptively
 
   // for logging
   static int CHECKPOINTS_DURATION;
@@ -104,6 +108,9 @@ struct Planner {
   void set_pibt();
   void set_refiner();
   Solution get_refined_plan(const Solution &plan_origin);
+  Solution get_scheduled_refined_plan(const Solution &plan);
+  Solution get_recursive_plan(const Solution &plan, const int t,
+                              const int refiner_seed);
   void update_checkpoints();
   void logging();
 };
@@ -7,19 +7,180 @@
 #include "instance.hpp"
 #include "utils.hpp"
 
+// safe interval, used in SIPP
+using SI = std::pair<int, int>;
+using SIs = std::vector<SI>;
+
 struct CollisionTable {
-  // vertex, time, agents
-  std::vector<std::vector<std::vector<int>>> body;
-  std::vector<std::vector<int>> body_last;
+  // reservation cell at (vertex, time)
+  // the previous vertex of each agent is kept, i.e., directed moves
+  // (from, to, t - 1 -> t) are indexed, making swap checks a single lookup
+  struct Cell {
+    int cnt;    // number of agents
+    int agent;  // one of them
+    int from;   // vertex-id of the agent at t - 1, -1 -> none
+    int next;   // the others, linked in overflow; -1 -> none
+  };
+  struct Link {
+    int agent;
+    int from;
+    int next;
+  };
+  // time-indexed cells of each vertex, stored in one arena
+  struct Row {
+    int offset;    // in cells
+    int capacity;  // multiple of 64
+    int length;    // 1 + the last enrolled time
+  };
+  std::vector<Row> rows;
+  std::vector<Cell> cells;
+  std::vector<uint64_t> occupied;  // bitset, aligned with cells
+  std::vector<Link> overflow;      // used when cnt >= 2
+  int overflow_free;               // head of free links
+
+  // vertex -> (time, agent) of agents staying there, sorted by time
+  using GoalEntries = std::vector<std::pair<int, int>>;
+  std::vector<GoalEntries> body_last;
   int collision_cnt;
   int N;
 
-  CollisionTable(const Instance *ins);
+  // copy-on-write overlay of a shared table, nullptr -> standalone
+  // rows and goal entries of the base are copied on the first write
+  const CollisionTable *base;
+  std::vector<char> is_local_row;
+  std::vector<char> is_local_goal;
+
+  // safe interval index, updated lazily for vertices touched since last use
+  const bool flg_safe_intervals;
+  std::vector<SIs> safe_intervals;
+  std::vector<bool> safe_intervals_dirty;
+
+  CollisionTable(const Instance *ins, const bool _flg_safe_intervals = false);
+  // the base must not be modified while the overlay is used
+  CollisionTable(const CollisionTable *_base,
+                 const bool _flg_safe_intervals = false);
   ~CollisionTable();
 
   int getCollisionCost(const Vertex *v_from, const Vertex *v_to,
-                       const int t_from);
+                       const int t_from) const;
   void enrollPath(const int i, Path &path);
   void clearPath(const int i, Path &path);
-  void shrink();
+  // append agents colliding with the enrolled path of agent-i, maybe duplicated
+  void getCollidingAgents(const int i, const Path &path,
+                          std::vector<int> &agents) const;
+
+  // occupancy queries
+  const GoalEntries &getGoalEntries(const int v_id) const;
+  int getRowLength(const int v_id) const;
+  int getOccupancy(const int v_id, const int t) const;
+  bool isOccupied(const int v_id, const int t) const;
+  // the first occupied time >= t at v, INT_MAX if none
+  int getNextOccupiedTime(const int v_id, const int t) const;
+  // the first free time >= t at v
+  int getNextFreeTime(const int v_id, const int t) const;
+  // the last free time <= t at v, -1 if none
+  int getPrevFreeTime(const int v_id, const int t) const;
+  // the number of agents moving from v_from to v_to at t - 1 -> t
+  int getMoveCount(const int v_from_id, const int v_to_id, const int t) const;
+  // the number of agents staying at v from before t
+  int getGoalCount(const int v_id, const int t) const;
+  // the earliest time when an agent stays at v forever, INT_MAX if none
+  int getGoalTime(const int v_id) const;
+  // departure time t in [t_lo, t_hi] such that the move from v_from to v_to
+  // at t -> t + 1 is collision-free, skipping occupied runs word by word
+  // earliest: INT_MAX if none, latest: -1 if none
+  int getEarliestFreeMove(const int v_from_id, const int v_to_id,
+                          const int t_lo, const int t_hi) const;
+  int getLatestFreeMove(const int v_from_id, const int v_to_id, const int t_lo,
+                        const int t_hi) const;
+  void computeSafeIntervals(const int v_id, SIs &intervals) const;
+  const SIs &getSafeIntervals(const int v_id);  // with the index enabled
+  template <typename F>
+  void forEachAgent(const int v_id, const int t, F &&f) const;
+
+private:
+  // table holding the row of v, i.e., this or the base
+  const CollisionTable &getTable(const int v_id) const;
+  void detachRow(const int v_id);
+  GoalEntries &detachGoalEntries(const int v_id);
+  int newLink();
+  void reserve(const int v_id, const int t);
+  void insertAgent(const int v_id, const int t, const int i,
+                   const int from_id);
+  void removeAgent(const int v_id, const int t, const int i);
 };
+
+inline const CollisionTable &CollisionTable::getTable(const int v_id) const
+{
+  return (base == nullptr || is_local_row[v_id]) ? *this : *base;
+}
+
+inline const CollisionTable::GoalEntries &CollisionTable::getGoalEntries(
+    const int v_id) const
+{
+  return (base == nullptr || is_local_goal[v_id]) ? body_last[v_id]
+                                                  : base->body_last[v_id];
+}
+
+inline int CollisionTable::getRowLength(const int v_id) const
+{
+  return getTable(v_id).rows[v_id].length;
+}
+
+inline int CollisionTable::getOccupancy(const int v_id, const int t) const
+{
+  auto &table = getTable(v_id);
+  auto &row = table.rows[v_id];
+  if (t < 0 || t >= row.length) return 0;
+  return table.cells[row.offset + t].cnt;
+}
+
+inline bool CollisionTable::isOccupied(const int v_id, const int t) const
+{
+  auto &table = getTable(v_id);
+  auto &row = table.rows[v_id];
+  if (t < 0 || t >= row.length) return false;
+  const auto k = row.offset + t;
+  return (table.occupied[k >> 6] >> (k & 63)) & 1;
+}
+
+inline int CollisionTable::getMoveCount(const int v_from_id, const int v_to_id,
+                                        const int t) const
+{
+  if (!isOccupied(v_to_id, t)) return 0;
+  auto &table = getTable(v_to_id);
+  auto &cell = table.cells[table.rows[v_to_id].offset + t];
+  auto cnt = (cell.from == v_from_id) ? 1 : 0;
+  for (auto l = cell.next; l != -1; l = table.overflow[l].next) {
+    if (table.overflow[l].from == v_from_id) ++cnt;
+  }
+  return cnt;
+}
+
+inline int CollisionTable::getGoalCount(const int v_id, const int t) const
+{
+  auto &entry = getGoalEntries(v_id);
+  if (entry.empty() || entry.front().first >= t) return 0;
+  return std::lower_bound(entry.begin(), entry.end(),
+                          std::make_pair(t, INT_MIN)) -
+         entry.begin();
+}
+
+inline int CollisionTable::getGoalTime(const int v_id) const
+{
+  auto &entry = getGoalEntries(v_id);
+  return entry.empty() ? INT_MAX : entry.front().first;
+}
+
+template <typename F>
+void CollisionTable::forEachAgent(const int v_id, const int t, F &&f) const
+{
+  const auto cnt = getOccupancy(v_id, t);
+  if (cnt == 0) return;
+  auto &table = getTable(v_id);
+  auto &cell = table.cells[table.rows[v_id].offset + t];
+  f(cell.agent);
+  for (auto l = cell.next; l != -1; l = table.overflow[l].next) {
+    f(table.overflow[l].agent);
+  }
+}
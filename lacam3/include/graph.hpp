@@ -11,6 +11,10 @@ struct Vertex {
   const int y;
   std::vector<Vertex *> neighbor;
 
+  // corridor, i.e., maximal chain of degree-2 vertices; -1 -> not in corridor
+  int corridor_id;
+  int corridor_pos;  // position along the corridor
+
   Vertex(int _id, int _index, int _x, int _y);
 };
 using Vertices = std::vector<Vertex *>;
@@ -23,11 +27,17 @@ struct Graph {
   Vertices U;  // with nullptr, i.e., |U| = width * height
   int width;   // grid width
   int height;  // grid height
+
+  // corridors, each of which is ordered along the chain
+  // c.f., the both ends are adjacent to junctions or dead ends
+  std::vector<Vertices> corridors;
+
   Graph();
   Graph(const std::string &filename);  // taking map filename
   ~Graph();
 
   int size() const;  // the number of vertices, |V|
+  void setup_corridors();  // preprocessing, used in PIBT swap
 };
 
 inline int manhattanDist(Vertex *a, Vertex *b)
@@ -24,6 +24,8 @@ struct HNode {
   int g;
   int h;
   int f;
+  int penalty;  // part of h given by the planner, -1 -> not computed
+  std::vector<int> mvc_cover;  // agents in the cover found by numvc, if any
 
   // for low-level search
   std::vector<float> priorities;
@@ -34,6 +34,7 @@ struct PIBT {
 
   // scatter
   Scatter *scatter;
+  std::vector<int> scatter_hints;  // last matched timestep, for each agent
 
   PIBT(const Instance *_ins, DistTable *_D, int seed = 0, bool _flg_swap = true,
        Scatter *_scatter = nullptr);
@@ -47,4 +48,5 @@ struct PIBT {
   bool is_swap_required(const int pusher, const int puller,
                         Vertex *v_pusher_origin, Vertex *v_puller_origin);
   bool is_swap_possible(Vertex *v_pusher_origin, Vertex *v_puller_origin);
+  void skip_corridor(Vertex *&v_pusher, Vertex *&v_puller);
 };
@@ -21,9 +21,94 @@
 #include "instance.hpp"
 #include "metrics.hpp"
 #include "sipp.hpp"
+#include "snapshot.hpp"
 #include "translator.hpp"
 #include "utils.hpp"
 
+// neighborhood generators, i.e., how to choose agents to be replanned
+enum RefinerNeighbor {
+  NB_ADAPTIVE = -1,  // choose one of the below per iteration, by gain per ms
+  NB_RANDOM = 0,     // disjoint chunks of a random agent order
+  NB_DELAY,          // the most delayed agent and ones on its shortest path
+  NB_INTERSECTION,   // agents around a busy intersection
+  NB_REGION,         // agents around a random vertex
+  NB_NUM
+};
+extern const char *REFINER_NEIGHBOR_NAMES[NB_NUM];
+// weight of the latest gain per ms when updating generator weights
+constexpr double REFINER_REACTION = 0.1;
+// delay-based ones take agents around the seed's shortest path in this window
+constexpr int REFINER_DELAY_WINDOW = 2;
+
+// generator statistics shared by refiners, thread-safe
+struct RefinerStats {
+  std::mutex mtx;
+  std::vector<double> weights;
+  std::vector<int> iter;
+  std::vector<int> gain;
+  std::vector<double> ms;
+
+  RefinerStats();
+  std::vector<double> get_weights();
+  void update(const std::vector<double> &_weights,
+              const std::vector<int> &_iter, const std::vector<int> &_gain,
+              const std::vector<double> &_ms);
+};
+
+// online scheduler of refiners, choosing recursive LaCAM or refine() with a
+// neighborhood size, by epsilon-greedy on the recent gain per ms; thread-safe
+struct RefinerScheduler {
+  struct Arm {
+    int size;      // neighborhood size of refine(), 0 -> recursive LaCAM
+    int pulls;
+    int updates;
+    int gain;
+    double ms;
+    double score;  // moving average of gain per ms
+  };
+  std::mutex mtx;
+  std::vector<Arm> arms;
+
+  RefinerScheduler(const bool flg_recursive = true,
+                   const bool flg_iterative = true);
+  // -1 -> no available arm
+  int select(std::mt19937 &MT, const bool flg_recursive = true);
+  void update(const int k, const int gain, const double ms);
+  std::string get_name(const int k) const;
+};
+constexpr double REFINER_SCHEDULER_EPSILON = 0.1;
+constexpr double REFINER_SCHEDULER_REACTION = 0.3;
+
 Solution refine(const Instance *ins, const Deadline *deadline,
                 const Solution &solution, DistTable *D, const int seed = 0,
-                const int verbose = 0);
+                const int verbose = 0, const int neighbor = NB_RANDOM,
+                RefinerStats *stats = nullptr,
+                const int neighbor_size = -1  // -1 -> random
+);
+// read a shared snapshot directly, nullptr -> failure
+SnapshotPtr refine(const Instance *ins, const Deadline *deadline,
+                   const Snapshot &solution, DistTable *D, const int seed = 0,
+                   const int verbose = 0, const int neighbor = NB_RANDOM,
+                   RefinerStats *stats = nullptr, const int neighbor_size = -1);
+
+// recursive LaCAM from the t-th configuration, by a child of the planner P
+// sharing its distance table; nullptr -> failure
+template <typename P>
+SnapshotPtr refine_recursively(const P &parent, const Snapshot &solution,
+                               const int t, const int seed)
+{
+  auto Q = Config();
+  solution.get_config(t, parent.ins->G, Q);
+  auto ins_tmp = Instance(parent.ins->G, Q, parent.ins->goals, parent.N);
+  ins_tmp.delete_graph_after_used = false;
+  const auto deadline = parent.deadline_refiner;
+  auto deadline_tmp = Deadline(
+      std::min(P::RECURSIVE_TIME_LIMIT,
+               deadline->time_limit_ms - elapsed_ms(deadline)),
+      deadline->flg_cancel);
+  auto planner_tmp =
+      P(&ins_tmp, 0, &deadline_tmp, seed, parent.depth + 1, parent.D);
+  auto res = planner_tmp.solve();
+  if (res.empty()) return nullptr;
+  return Snapshot::from_configs(res);
+}
@@ -0,0 +1,39 @@
+/*
+ * persistent workers running refiners
+ */
+#pragma once
+
+#include "instance.hpp"
+#include "snapshot.hpp"
+#include "utils.hpp"
+
+struct RefinerResult {
+  SnapshotPtr base;  // solution given to the refiner
+  SnapshotPtr plan;  // nullptr -> failure
+  int t_start;       // plan starts from the configuration of base at this time
+};
+
+struct RefinerPool {
+  using Job = std::function<RefinerResult()>;
+
+  std::vector<std::thread> workers;
+  std::deque<Job> jobs;                // waiting
+  std::deque<RefinerResult> finished;  // completion queue
+  int num_running;
+  bool flg_stop;
+  std::atomic<bool> flg_cancel;  // read by refiners via their deadline
+  std::mutex mtx;
+  std::condition_variable cv_job;
+  std::condition_variable cv_done;
+
+  RefinerPool(const int num_workers);
+  ~RefinerPool();
+  void submit(Job job);
+  // pop one finished result if any, without blocking, including failures
+  bool pop_finished(RefinerResult &result);
+  // drop waiting jobs, ask running ones to stop, and wait for them
+  void cancel();
+
+private:
+  void work();
+};
@@ -14,6 +14,53 @@
 #include "graph.hpp"
 #include "utils.hpp"
 
+// working memory of the single-agent search in SUO, one for each thread
+// OPEN is a two-level bucket queue, keyed by (collision, f); both are small
+// integers and keys of pushed nodes never fall below the last popped one
+struct ScatterWorkspace {
+  struct Node {
+    Vertex *v;
+    int g;  // cost-to-come
+    int c;  // collision
+    Vertex *parent;
+  };
+
+  const int f_range;                  // f - f_min in [0, f_range)
+  std::vector<Vertex *> CLOSED;       // parent
+  std::vector<int> USED;              // vertex-id list, used with CLOSED
+  std::vector<Node> nodes;            // node pool
+  std::vector<std::vector<int>> buckets;  // (collision, f offset) -> nodes
+  int size;
+  int c_cur;  // cursor
+  int f_cur;
+  int c_max;
+
+  ScatterWorkspace(const int V_size, const int _f_range);
+  void clear();
+  void push(const Node &n, const int f_offset);
+  Node pop();
+};
+
+// threads kept through a parallel SUO, each round runs fn(k) for every
+// worker k, the caller being worker 0, and returns when all are done
+struct ScatterWorkers {
+  std::vector<std::thread> threads;
+  const std::function<void(int)> *job;
+  int generation;
+  int num_pending;
+  bool flg_stop;
+  std::mutex mtx;
+  std::condition_variable cv_start;
+  std::condition_variable cv_done;
+
+  ScatterWorkers(const int num_workers);
+  ~ScatterWorkers();
+  void run(const std::function<void(int)> &fn);
+
+private:
+  void work(const int k);
+};
+
 struct Scatter {
   const Instance *ins;
   const Deadline *deadline;
@@ -24,18 +71,32 @@ struct Scatter {
   const int T;  // makespan lower bound
   DistTable *D;
   const int cost_margin;
+  const int num_threads;  // > 1 -> parallel SUO with agent batches
   int sum_of_path_length;
 
   // outcome
   std::vector<Path> paths;
-  // agent, vertex-id, next vertex
-  std::vector<std::unordered_map<int, Vertex *>> scatter_data;
+  // agent -> (vertex-id, timestep) on its path sorted by vertex-id,
+  // flattened and read-only, shared by all PIBT workers
+  std::vector<int> scatter_offsets;
+  std::vector<std::pair<int, int>> scatter_data;
 
   // collision data
   CollisionTable CT;
 
   void construct();
+  void replan(const int i, ScatterWorkspace &W);
+  void replan_batch(const std::vector<int> &batch,
+                    std::vector<ScatterWorkspace> &W_pool,
+                    ScatterWorkers &workers);
+  std::vector<std::vector<int>> get_batches(std::vector<int> &order);
+  // collision-aware A*
+  Path find_path(const int i, ScatterWorkspace &W, int &collision);
+  int get_path_collision(const Path &path);
+  // next vertex of agent-i at v, hint: timestep of the last query
+  Vertex *get_next(const int i, const Vertex *v, int &hint) const;
 
   Scatter(const Instance *_ins, DistTable *_D, const Deadline *_deadline,
-          const int seed = 0, int _verbose = 0, int _cost_margin = 2);
+          const int seed = 0, int _verbose = 0, int _cost_margin = 2,
+          int _num_threads = 1);
 };
@@ -15,41 +15,56 @@
 #include "graph.hpp"
 #include "utils.hpp"
 
-// safe interval
-using SI = std::pair<int, int>;
-using SIs = std::vector<SI>;
-
+// safe interval table, reading the index of CT when enabled
 struct SITable {
   std::unordered_map<int, SIs> body;
   CollisionTable *CT;
 
   SITable(CollisionTable *_CT);
   ~SITable();
-  SIs &get(Vertex *v);
+  const SIs &get(Vertex *v);
 };
 
 struct SINode {
-  const int uuid;
-  const int time_start;
-  const int time_end;
+  int time_start;
+  int time_end;
+  int si_index;  // in the safe intervals of v
   Vertex *v;
-  const int t;  // arrival time
-  const int g;
-  const int f;
-  SINode *parent;
-
-  SINode(const int uuid, const SI &si, Vertex *_v, int _t, int _g, int _f,
-         SINode *_parent);
-  bool operator==(const SINode &other) const;
+  int t;  // arrival time
+  int g;
+  int f;
+  int parent;  // index in the workspace, -1 -> none
 };
-using SINodes = std::vector<SINode *>;
+using SINodes = std::vector<SINode>;
+
+// reusable storage of sipp, kept per thread to avoid allocation per query
+struct SIPPWorkspace {
+  // explored node of (vertex, safe interval), valid when gen matches
+  struct Entry {
+    uint gen;
+    int v_id;
+    int si_index;
+    int node;
+  };
+  SINodes nodes;
+  std::vector<int> OPEN;        // heap of node indexes
+  std::vector<Entry> explored;  // open addressing, power of two size
+  int explored_size;
+  uint gen;
+
+  SIPPWorkspace();
+  void clear();
+  int new_node(const SINode &n);
+  // node index, -1 -> unexplored
+  int get_explored(const int v_id, const int si_index) const;
+  void set_explored(const int v_id, const int si_index, const int node);
 
-struct SINodeHasher {
-  uint operator()(const SINode &n) const;
+private:
+  int find_slot(const int v_id, const int si_index) const;
 };
 
 Path sipp(const int i, Vertex *s_i, Vertex *g_i, DistTable *D,
           CollisionTable *CT, const Deadline *deadline = nullptr,
           const int f_upper_bound = INT_MAX);
 
-std::ostream &operator<<(std::ostream &os, const SINode *n);
+std::ostream &operator<<(std::ostream &os, const SINode &n);
@@ -0,0 +1,47 @@
+/*
+ * immutable solution shared by the planner and refiners
+ */
+#pragma once
+
+#include "collision_table.hpp"
+#include "graph.hpp"
+#include "hnode.hpp"
+#include "instance.hpp"
+#include "utils.hpp"
+
+struct Snapshot;
+using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+// path-major layout, each path is cut when the agent finally reaches its goal
+struct Snapshot {
+  int N;
+  int T;                        // makespan
+  std::vector<int> offsets;     // agent -> begin of its path, size N + 1
+  std::vector<int> vertex_ids;  // concatenated paths
+  HNodes nodes;                 // timestep -> search node, when known
+
+  Snapshot(const int _N = 0);
+  static SnapshotPtr from_configs(const Solution &solution);
+  // empty paths are taken from the fallback, i.e., unchanged agents
+  static SnapshotPtr from_paths(const Paths &paths,
+                                const Snapshot *fallback = nullptr);
+  // from consecutive search nodes, from start to goal
+  explicit Snapshot(const HNodes &_nodes);
+
+  int get_vertex_id(const int i, const int t) const;
+  // whether the configuration at t equals that of other at t_other
+  bool is_same_config(const int t, const Snapshot &other,
+                      const int t_other) const;
+  void get_config(const int t, const Graph *G, Config &Q) const;
+  int get_sum_of_loss(const int t_from = 0) const;
+  int get_path_loss(const int i) const;
+  void get_path(const int i, const Graph *G, Path &path) const;
+  Paths get_paths(const Graph *G) const;
+  Solution get_solution(const Graph *G) const;
+  // reservation table of all paths, built once and shared by refiners
+  const CollisionTable *get_collision_table(const Instance *ins) const;
+
+private:
+  mutable std::once_flag flg_collision_table;
+  mutable std::unique_ptr<CollisionTable> collision_table;
+};
@@ -5,14 +5,21 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <future>
 #include <iomanip>
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <queue>
 #include <random>
@@ -20,6 +27,7 @@
 #include <set>
 #include <stack>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -29,8 +37,12 @@ using Time = std::chrono::steady_clock;
 struct Deadline {
   const Time::time_point t_s;
   const double time_limit_ms;
+  const std::atomic<bool> *flg_cancel;  // expired when set, nullptr -> none
 
-  Deadline(double _time_limit_ms = 0);
+  Deadline(double _time_limit_ms = 0,
+           const std::atomic<bool> *_flg_cancel = nullptr);
+  // same time limit as the parent, nullptr -> unlimited
+  Deadline(const Deadline *parent, const std::atomic<bool> *_flg_cancel);
   double elapsed_ms() const;
   double elapsed_ns() const;
 };
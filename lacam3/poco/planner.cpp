@@ -1,14 +1,18 @@
 #include "planner.hpp"
 #include "conflictoracle.hpp"
+#include "mvc_kernel.h"
 #include "numvc.h"
 #include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <functional>
+#include <numeric>
 
 bool Planner::FLG_SWAP = true;
 bool Planner::FLG_STAR = true;
 bool Planner::FLG_MULTI_THREAD = true;
 int Planner::SCATTER_MARGIN = 10;
+int Planner::SCATTER_THREADS = 1;
 int Planner::PIBT_NUM = 10;
 bool Planner::FLG_REFINER = true;
 int Planner::REFINER_NUM = 4;
@@ -18,13 +22,13 @@ float Planner::RANDOM_INSERT_PROB2 = 0.01;
 bool Planner::FLG_RANDOM_INSERT_INIT_NODE = false;
 float Planner::RECURSIVE_RATE = 0.2;
 double Planner::RECURSIVE_TIME_LIMIT = 1000;
+int Planner::REFINER_NEIGHBOR = NB_RANDOM;
+bool Planner::FLG_REFINER_SCHEDULER = false;
 
 std::string Planner::MSG;
 int Planner::CHECKPOINTS_DURATION = 5000;
 constexpr int CHECKPOINTS_NIL = -1;
 
-constexpr auto TIME_ZERO = std::chrono::seconds(0);
-
 Planner::Planner(const Instance *_ins, int _verbose, const Deadline *_deadline,
                  int _seed, int _depth, DistTable *_D)
     : ins(_ins),
@@ -40,11 +44,21 @@ Planner::Planner(const Instance *_ins, int _verbose, const Deadline *_deadline,
       heuristic(new Heuristic(ins, D)),
       scatter(nullptr),
       seed_refiner(0),
-      refiner_pool(),
+      refiner_pool(nullptr),
+      incumbent(nullptr),
+      incumbent_cost(-1),
+      deadline_refiner(nullptr),
+      refiner_stats(),
+      refiner_scheduler(RECURSIVE_RATE > 0, RECURSIVE_RATE < 1.0),
       OPEN(),
       EXPLORED(),
       H_init(nullptr),
       H_goal(nullptr),
+      mvc_solved(0),
+      mvc_skipped(0),
+      mvc_waves(0),
+      pibt_duplicates(0),
+      pibt_known(0),
       search_iter(0),
       time_initial_solution(-1),
       cost_initial_solution(-1),
@@ -58,17 +72,21 @@ Planner::Planner(const Instance *_ins, int _verbose, const Deadline *_deadline,
         starts[i].x = s->x; starts[i].y = s->y;
         goals[i].x = g->x; goals[i].y = g->y;
       }
+      mvc_cache_clear();
       current_pos.resize(PIBT_NUM);
       for (int k = 0; k < PIBT_NUM; ++k) {
           current_pos[k].resize(N);
           thread_cos.emplace_back(std::make_unique<ConflictOracle>(starts, goals));
           thread_cos[k]->set_mvc_solver(numvc);
+          mvc_solvers.emplace_back(std::make_unique<NumvcSolver>());
       }
   }
 }
 
 Planner::~Planner()
 {
+  if (refiner_pool != nullptr) delete refiner_pool;
+  if (deadline_refiner != nullptr) delete deadline_refiner;
   if (heuristic != nullptr) delete heuristic;
   if (scatter != nullptr) delete scatter;
   for (auto &pibt : pibts) delete pibt;
@@ -92,16 +110,14 @@ Solution Planner::solve()
     search_iter += 1;
     update_checkpoints();
 
-    // check pooled procedures
-    refiner_pool.remove_if([&](auto &proc) {
-      if ((proc).wait_for(TIME_ZERO) != std::future_status::ready) return false;
-      apply_new_solution(proc.get());
-      ++seed_refiner;
-      refiner_pool.emplace_back(std::async(std::launch::async,
-                                           &Planner::get_refined_plan, this,
-                                           backtrack(H_goal)));
-      return true;
-    });
+    // check finished refiners
+    if (refiner_pool != nullptr) {
+      auto result = RefinerResult();
+      while (refiner_pool->pop_finished(result)) {
+        apply_new_solution(result);
+        submit_refiner(get_incumbent());
+      }
+    }
 
     // do not pop here!
     auto H = OPEN.front();
@@ -141,7 +157,8 @@ Solution Planner::solve()
     auto L = H->search_tree.front();
     auto Q_to = Config(N, nullptr);
     uint penalty = 0;
-    auto res = set_new_config_penalty(H, L, Q_to, penalty);
+    auto cover = std::vector<int>();
+    auto res = set_new_config_penalty(H, L, Q_to, penalty, cover);
     if(!res){
       delete L;
       H->search_tree.pop();
@@ -164,13 +181,18 @@ Solution Planner::solve()
     } else {
       // new one -> insert
       auto H_new = create_highlevel_node_penalty(Q_to, H, penalty);
+      H_new->mvc_cover = std::move(cover);
       OPEN.push_front(H_new);
     }
   }
 
   // clear pooled operaitons
   bool is_optimal = OPEN.empty();
-  for (auto &proc : refiner_pool) apply_new_solution(proc.get());
+  if (refiner_pool != nullptr) {
+    refiner_pool->cancel();
+    auto result = RefinerResult();
+    while (refiner_pool->pop_finished(result)) apply_new_solution(result);
+  }
   if (is_optimal) OPEN.clear();
 
   // end processing
@@ -196,6 +218,13 @@ Solution Planner::solve()
     MSG += "\ncal_mvc_time_us=" + std::to_string(cal_mvc_time_us);
     MSG += "\npoco_call_count=" + std::to_string(poco_call_count);
     MSG += "\npoco_result=" + std::to_string(poco_result);
+    MSG += "\nmvc_cache_hits=" + std::to_string(mvc_cache_get_hits());
+    MSG += "\nmvc_cache_misses=" + std::to_string(mvc_cache_get_misses());
+    MSG += "\nmvc_solved=" + std::to_string(mvc_solved);
+    MSG += "\nmvc_skipped=" + std::to_string(mvc_skipped);
+    MSG += "\nmvc_waves=" + std::to_string(mvc_waves);
+    MSG += "\npibt_duplicates=" + std::to_string(pibt_duplicates);
+    MSG += "\npibt_known=" + std::to_string(pibt_known);
   }
   return solution;
 }
@@ -206,20 +235,38 @@ HNode *Planner::create_highlevel_node_penalty(const Config &Q, HNode *parent, ui
       (parent == nullptr) ? 0 : parent->g + get_edge_cost(parent->C, Q);
   auto h_val = heuristic->get(Q) + penalty;
   auto H_new = new HNode(Q, D, parent, g_val, h_val);
+  // conflict penalties are computed for successors before the first solution
+  if (parent != nullptr && depth == 0 && H_goal == nullptr) {
+    H_new->penalty = penalty;
+  }
   EXPLORED[Q] = H_new;
   return H_new;
 }
 
-void Planner::apply_new_solution(const Solution &plan)
+void Planner::apply_new_solution(const RefinerResult &result)
 {
-  if (plan.empty()) return;
+  if (result.plan == nullptr) return;  // failed refiner
+  auto &plan = *result.plan;
+  auto &base = *result.base;
   info(3, verbose, deadline, "incorporate new solution");
 
-  // forcibly insert configuration
-  HNode *H_from = EXPLORED[plan[0]];
+  // forcibly insert configurations that differ from the base
+  HNode *H_from = base.nodes[result.t_start];
   HNode *H_to = nullptr;
-  for (auto t = 1; t < plan.size(); ++t) {
-    auto &&Q = plan[t];
+  auto Q = Config();
+  auto is_changed_prev = false;
+  for (auto t = 1; t <= plan.T; ++t) {
+    const auto t_base = result.t_start + t;
+    if (plan.is_same_config(t, base, t_base)) {
+      // the base has the edge already unless coming back from a detour
+      H_to = base.nodes[t_base];
+      if (is_changed_prev) rewrite(H_from, H_to);
+      is_changed_prev = false;
+      H_from = H_to;
+      continue;
+    }
+    is_changed_prev = true;
+    plan.get_config(t, ins->G, Q);
     auto iter = EXPLORED.find(Q);
     if (iter != EXPLORED.end()) {
       // known
@@ -236,6 +283,20 @@ void Planner::apply_new_solution(const Solution &plan)
   }
 }
 
+SnapshotPtr Planner::get_incumbent()
+{
+  // rebuild only when the goal has been improved
+  if (incumbent == nullptr || incumbent->nodes.back() != H_goal ||
+      incumbent_cost != H_goal->g) {
+    auto nodes = HNodes();
+    for (auto H = H_goal; H != nullptr; H = H->parent) nodes.push_back(H);
+    std::reverse(nodes.begin(), nodes.end());
+    incumbent = std::make_shared<const Snapshot>(nodes);
+    incumbent_cost = H_goal->g;
+  }
+  return incumbent;
+}
+
 Solution Planner::backtrack(HNode *H)
 {
   std::vector<Config> plan;
@@ -248,44 +309,137 @@ Solution Planner::backtrack(HNode *H)
   return plan;
 }
 
-bool Planner::set_new_config_penalty(HNode *H, LNode *L, Config &Q_to, uint &penalty)
+bool Planner::set_new_config_penalty(HNode *H, LNode *L, Config &Q_to,
+                                     uint &penalty, std::vector<int> &cover)
 {
   // worker-id, time -> configuration
   auto Q_cands = std::vector<Config>(PIBT_NUM, Config(N, nullptr));
   auto f_vals = std::vector<int>(PIBT_NUM, INT_MAX);
+  auto f_base = std::vector<int>(PIBT_NUM, INT_MAX);  // without penalty
+  auto is_known = std::vector<char>(PIBT_NUM, false);  // penalty in EXPLORED
   auto mvc = std::vector<int>(PIBT_NUM, 0);
   auto hedges = std::vector<int>(PIBT_NUM, 0);
   auto cedges = std::vector<int>(PIBT_NUM, 0);
+  auto covers = std::vector<std::vector<int>>(PIBT_NUM);  // agents, by numvc
   bool use_conflict = this->depth == 0 && H_goal == nullptr;
 
-  // parallel
-  auto worker = [&](int k) {
+  // run the worker for the given candidates, in parallel if allowed
+  auto all = std::vector<int>(PIBT_NUM);
+  std::iota(all.begin(), all.end(), 0);
+  auto run = [&](const std::vector<int> &ks,
+                 const std::function<void(int)> &worker) {
+    if (FLG_MULTI_THREAD && ks.size() > 1) {
+      auto threads = std::vector<std::thread>();
+      for (auto k : ks) threads.emplace_back(worker, k);
+      for (auto &th : threads) th.join();
+    } else {
+      for (auto k : ks) worker(k);
+    }
+  };
+  auto update_calmvc = [&](int k, bool lb) {
+    numvc_bind_solver(mvc_solvers[k].get());
+    // numvc repairs the cover of the parent configuration
+    if (!lb) mvc_bind_cover(&H->mvc_cover, &covers[k]);
+    for (size_t i = 0; i < N; i++)
+      current_pos[k][i] = {Q_cands[k][i]->x, Q_cands[k][i]->y};
+    thread_cos[k]->update_calmvc(current_pos[k], lb, mvc[k], hedges[k],
+                                 cedges[k]);
+    mvc_bind_cover(nullptr, nullptr);
+    numvc_bind_solver(nullptr);
+  };
+
+  // parallel, PIBT
+  run(all, [&](int k) {
     // set constraints
     for (auto d = 0; d < L->depth; ++d) Q_cands[k][L->who[d]] = L->where[d];
     // PIBT
     auto res = pibts[k]->set_new_config(H->C, Q_cands[k], H->order);
-    if (res){
-      // get the lower bound of vertex cover
-      Config &cand = Q_cands[k];
-      if (use_conflict &&  thread_cos[k]){
-        for (size_t i = 0; i < N; i++)
-          current_pos[k][i] = {cand[i]->x, cand[i]->y};
-#ifdef USE_MVC_LB
-          thread_cos[k]->update_calmvc(current_pos[k], true, mvc[k], hedges[k], cedges[k]);
-#else
-          thread_cos[k]->update_calmvc(current_pos[k], false, mvc[k], hedges[k], cedges[k]);
-#endif
+    if (res) {
+      f_base[k] = get_edge_cost(H->C, Q_cands[k]) + heuristic->get(Q_cands[k]);
+    }
+  });
+
+  // score each configuration once, the first worker wins ties anyway;
+  // explored ones keep their penalty if computed, the start has none
+  auto hasher = ConfigHasher();
+  auto hashes = std::vector<uint>(PIBT_NUM, 0);
+  for (auto k = 0; k < PIBT_NUM; ++k) {
+    if (f_base[k] == INT_MAX) continue;
+    hashes[k] = hasher(Q_cands[k]);
+    for (auto l = 0; l < k; ++l) {
+      if (f_base[l] < INT_MAX && hashes[l] == hashes[k] &&
+          Q_cands[l] == Q_cands[k]) {
+        f_base[k] = INT_MAX;
+        ++pibt_duplicates;
+        break;
       }
-      f_vals[k] = get_edge_cost(H->C, cand) + heuristic->get(cand) + mvc[k];
     }
-  };
-  if (FLG_MULTI_THREAD && PIBT_NUM > 1) {
-    auto threads = std::vector<std::thread>();
-    for (auto k = 0; k < PIBT_NUM; ++k) threads.emplace_back(worker, k);
-    for (auto &th : threads) th.join();
-  } else {
-    for (auto k = 0; k < PIBT_NUM; ++k) worker(k);
+    if (f_base[k] == INT_MAX || !use_conflict) continue;
+    auto iter = EXPLORED.find(Q_cands[k]);
+    if (iter != EXPLORED.end() && iter->second->penalty >= 0) {
+      mvc[k] = iter->second->penalty;
+      is_known[k] = true;
+      ++pibt_known;
+    }
+  }
+
+  // parallel, lower bound of vertex cover, the penalty itself with USE_MVC_LB
+  if (use_conflict) {
+    run(all, [&](int k) {
+      if (f_base[k] < INT_MAX && !is_known[k] && thread_cos[k]) {
+        update_calmvc(k, true);
+      }
+    });
+  }
+  for (auto k = 0; k < PIBT_NUM; ++k) {
+    if (f_base[k] < INT_MAX) f_vals[k] = f_base[k] + mvc[k];
+  }
+
+#ifndef USE_MVC_LB
+  // exact vertex cover in waves, in increasing order of the lower bound;
+  // each wave solves in parallel the candidates that can still win, the
+  // first one those tied at the smallest bound
+  if (use_conflict) {
+    auto order = std::vector<int>();
+    for (auto k = 0; k < PIBT_NUM; ++k) {
+      if (f_base[k] < INT_MAX && thread_cos[k]) order.push_back(k);
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+      return f_vals[a] != f_vals[b] ? f_vals[a] < f_vals[b] : a < b;
+    });
+    auto best_f = INT_MAX;
+    auto best_k = -1;
+    auto can_win = [&](int k) {
+      return f_vals[k] < best_f || (f_vals[k] == best_f && k < best_k);
+    };
+    auto wave = std::vector<int>();
+    auto j = 0;
+    while (j < (int)order.size() && can_win(order[j])) {
+      const auto f_wave = best_f < INT_MAX ? best_f : f_vals[order[j]];
+      const auto j_begin = j;
+      wave.clear();
+      for (; j < (int)order.size() && can_win(order[j]) &&
+             f_vals[order[j]] <= f_wave;
+           ++j) {
+        if (!is_known[order[j]]) wave.push_back(order[j]);
+      }
+      run(wave, [&](int k) { update_calmvc(k, false); });
+      mvc_solved += wave.size();
+      ++mvc_waves;
+      for (auto l = j_begin; l < j; ++l) {
+        const auto k = order[l];
+        f_vals[k] = f_base[k] + mvc[k];
+        if (f_vals[k] < best_f || (f_vals[k] == best_f && k < best_k)) {
+          best_f = f_vals[k];
+          best_k = k;
+        }
+      }
+    }
+    // not evaluated -> never chosen below
+    mvc_skipped += order.size() - j;
+    for (; j < (int)order.size(); ++j) f_vals[order[j]] = INT_MAX;
   }
+#endif
 
   // obtain the best score
   auto min_f_val = INT_MAX;
@@ -301,6 +455,7 @@ bool Planner::set_new_config_penalty(HNode *H, LNode *L, Config &Q_to, uint &pen
     auto &Q_win = Q_cands[min_f_val_idx];
     std::copy(Q_win.begin(), Q_win.end(), Q_to.begin());
     penalty = mvc[min_f_val_idx];
+    cover = std::move(covers[min_f_val_idx]);
     return true;
   } else {
     return false;
@@ -352,7 +507,8 @@ void Planner::set_scatter()
                    ? INT_MAX
                    : (deadline->time_limit_ms - elapsed_ms(deadline)) / 2);
   auto margin = SCATTER_MARGIN < 0 ? get_random_int(MT, 0, 30) : SCATTER_MARGIN;
-  scatter = new Scatter(ins, D, &scatter_deadline, 3, verbose - 4, margin);
+  scatter = new Scatter(ins, D, &scatter_deadline, 3, verbose - 4, margin,
+                        FLG_MULTI_THREAD ? SCATTER_THREADS : 1);
   scatter->construct();
   info(1, verbose, deadline, "finish computing SUO",
        ", collision count: ", scatter->CT.collision_cnt,
@@ -371,45 +527,87 @@ void Planner::set_refiner()
 {
   if (!FLG_REFINER) return;
   if (!FLG_MULTI_THREAD) return;
-  auto plan = backtrack(H_goal);
+  auto plan = get_incumbent();
   info(2, verbose, deadline, "invoke refiners");
-  for (auto k = 0; k < REFINER_NUM; ++k) {
-    ++seed_refiner;
-    refiner_pool.emplace_back(
-        std::async(std::launch::async, &Planner::get_refined_plan, this, plan));
-  }
+  refiner_pool = new RefinerPool(REFINER_NUM);
+  deadline_refiner = new Deadline(deadline, &refiner_pool->flg_cancel);
+  for (auto k = 0; k < REFINER_NUM; ++k) submit_refiner(plan);
 }
 
-Solution Planner::get_refined_plan(const Solution &plan)
+void Planner::submit_refiner(const SnapshotPtr &plan)
 {
-  auto MT_internal = std::mt19937(seed_refiner);
-  if (depth < 1 && plan.size() > 3 &&
+  ++seed_refiner;
+  refiner_pool->submit([this, plan, refiner_seed = seed_refiner] {
+    return get_refined_plan(plan, refiner_seed);
+  });
+}
+
+RefinerResult Planner::get_refined_plan(const SnapshotPtr &plan,
+                                        const int refiner_seed)
+{
+  if (FLG_REFINER_SCHEDULER) {
+    return get_scheduled_refined_plan(plan, refiner_seed);
+  }
+  auto MT_internal = std::mt19937(refiner_seed);
+  if (depth < 1 && plan->T > 2 &&
       get_random_float(MT_internal) < RECURSIVE_RATE) {
     // recursive LaCAM
-    auto ins_tmp =
-        Instance(ins->G, plan[get_random_int(MT_internal, 1, plan.size() - 2)],
-                 ins->goals, N);
-    ins_tmp.delete_graph_after_used = false;
-    auto deadline_tmp = Deadline(std::min(
-        RECURSIVE_TIME_LIMIT,
-        deadline == nullptr ? INT_MAX
-                            : deadline->time_limit_ms - elapsed_ms(deadline)));
-    auto planner_tmp =
-        Planner(&ins_tmp, 0, &deadline_tmp, seed_refiner, depth + 1, D);
-    info(4, verbose, deadline, "refiner-", planner_tmp.seed,
+    const auto t = get_random_int(MT_internal, 1, plan->T - 1);
+    info(4, verbose, deadline_refiner, "refiner-", refiner_seed,
          "\tactivated (recursive LaCAM)");
-    auto res = planner_tmp.solve();
-    info(4, verbose, deadline, "refiner-", planner_tmp.seed,
+    auto res = refine_recursively(*this, *plan, t, refiner_seed);
+    info(4, verbose, deadline_refiner, "refiner-", refiner_seed,
          "\tcompleted (recursive LaCAM)");
-    return res;
+    return {plan, res, t};
   } else if (RECURSIVE_RATE < 1.0) {
     // iterative refinement
-    return refine(ins, deadline, plan, D, seed_refiner, verbose - 4);
+    return {plan,
+            refine(ins, deadline_refiner, *plan, D, refiner_seed, verbose - 4,
+                   REFINER_NEIGHBOR, &refiner_stats),
+            0};
   } else {
-    return Solution();
+    return {plan, nullptr, 0};
   }
 }
 
+RefinerResult Planner::get_scheduled_refined_plan(const SnapshotPtr &plan,
+                                                  const int refiner_seed)
+{
+  auto MT_internal = std::mt19937(refiner_seed);
+  const auto k =
+      refiner_scheduler.select(MT_internal, depth < 1 && plan->T > 2);
+  if (k == -1) return {plan, nullptr, 0};
+  const auto name = refiner_scheduler.get_name(k);
+  info(4, verbose, deadline_refiner, "refiner-", refiner_seed,
+       "\tscheduled: ", name);
+  const auto t_start = Time::now();
+  auto res = RefinerResult{plan, nullptr, 0};
+  auto gain = 0;
+  if (refiner_scheduler.arms[k].size == 0) {
+    // recursive LaCAM, from the middle of the plan
+    const auto t = get_random_int(MT_internal, 1, plan->T - 1);
+    res.plan = refine_recursively(*this, *plan, t, refiner_seed);
+    if (res.plan != nullptr) {
+      res.t_start = t;
+      gain = plan->get_sum_of_loss(t) - res.plan->get_sum_of_loss();
+    }
+  } else {
+    // iterative refinement
+    res.plan = refine(ins, deadline_refiner, *plan, D, refiner_seed,
+                      verbose - 4, REFINER_NEIGHBOR, &refiner_stats,
+                      refiner_scheduler.arms[k].size);
+    if (res.plan != nullptr) {
+      gain = plan->get_sum_of_loss() - res.plan->get_sum_of_loss();
+    }
+  }
+  const auto ms =
+      std::chrono::duration<double, std::milli>(Time::now() - t_start).count();
+  refiner_scheduler.update(k, std::max(gain, 0), ms);
+  info(4, verbose, deadline_refiner, "refiner-", refiner_seed,
+       "\tcompleted: ", name, ", gain: ", gain, ", ms: ", ms);
+  return res;
+}
+
 void Planner::update_checkpoints()
 {
   const auto time = elapsed_ms(deadline);
@@ -429,6 +627,24 @@ void Planner::logging()
   MSG += "\nsearch_iteration=" + std::to_string(search_iter);
   MSG += "\nnum_high_level_node=" + std::to_string(HNode::COUNT);
   MSG += "\nnum_low_level_node=" + std::to_string(LNode::COUNT);
+  MSG += "\nrefiner_neighbors=";
+  for (auto nb = 0; nb < NB_NUM; ++nb) {
+    // name:iterations:gain:ms
+    MSG += std::string(REFINER_NEIGHBOR_NAMES[nb]) + ":" +
+           std::to_string(refiner_stats.iter[nb]) + ":" +
+           std::to_string(refiner_stats.gain[nb]) + ":" +
+           std::to_string(int(refiner_stats.ms[nb])) + ",";
+  }
+  if (FLG_REFINER_SCHEDULER) {
+    MSG += "\nrefiner_arms=";
+    for (auto k = 0; k < (int)refiner_scheduler.arms.size(); ++k) {
+      // name:pulls:gain:ms
+      auto &arm = refiner_scheduler.arms[k];
+      MSG += refiner_scheduler.get_name(k) + ":" + std::to_string(arm.pulls) +
+             ":" + std::to_string(arm.gain) + ":" +
+             std::to_string(int(arm.ms)) + ",";
+    }
+  }
 
   if (H_goal != nullptr && OPEN.empty()) {
     info(1, verbose, deadline, "solved optimally, cost:", H_goal->g);
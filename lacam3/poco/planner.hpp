@@ -23,12 +23,14 @@
 #include "instance.hpp"
 #include "pibt.hpp"
 #include "refiner.hpp"
+#include "refiner_pool.hpp"
 #include "scatter.hpp"
 #include "translator.hpp"
 #include "utils.hpp"
 
 struct Point;
 class ConflictOracle;
+class NumvcSolver;
 struct Planner {
   const Instance *ins;
   const Deadline *deadline;
@@ -54,7 +56,12 @@ struct Planner {
 
   // for refiner
   int seed_refiner;
-  std::list<std::future<Solution>> refiner_pool;
+  RefinerPool *refiner_pool;
+  SnapshotPtr incumbent;  // latest solution given to refiners
+  int incumbent_cost;
+  Deadline *deadline_refiner;  // cancelled when the search ends
+  RefinerStats refiner_stats;
+  RefinerScheduler refiner_scheduler;
 
   // for search utils
   std::deque<HNode *> OPEN;
@@ -65,6 +72,16 @@ struct Planner {
   // a denpendency graph for hostile relations
   std::vector<std::unique_ptr<ConflictOracle>> thread_cos;  // each thread has a ConflictOracle
   std::vector<std::vector<Point>> current_pos;
+  // MVC solver of each thread, reused across calls
+  std::vector<std::unique_ptr<NumvcSolver>> mvc_solvers;
+  // exact MVC solves done and skipped by the lower bound, and parallel
+  // rounds of the solves
+  long long mvc_solved;
+  long long mvc_skipped;
+  long long mvc_waves;
+  // candidates scored by an identical one or found in EXPLORED
+  long long pibt_duplicates;
+  long long pibt_known;
 
   // parameters
   static bool FLG_SWAP;  // whether to use swap technique in PIBT
@@ -72,6 +89,7 @@ struct Planner {
       FLG_STAR;  // whether to refine solutions after initial solution discovery
   static bool FLG_MULTI_THREAD;
   static int SCATTER_MARGIN;  // used in SUO
+  static int SCATTER_THREADS;  // number of threads used in SUO
   static int PIBT_NUM;  // number of PIBT run, i.e., Monte-Carlo configuration
                         // generator
   static bool FLG_REFINER;  // whether to use refiners
@@ -83,6 +101,8 @@ struct Planner {
   static bool FLG_RANDOM_INSERT_INIT_NODE;
   static float RECURSIVE_RATE;
   static double RECURSIVE_TIME_LIMIT;
+  static int REFINER_NEIGHBOR;  // neighborhood generator of refiners
+  static bool FLG_REFINER_SCHEDULER;  // whether to choose refiners adaptively
 
   // for logging
   static int CHECKPOINTS_DURATION;
@@ -100,16 +120,22 @@ struct Planner {
   );
   ~Planner();
   Solution solve();
-  bool set_new_config_penalty(HNode *S, LNode *M, Config &Q_to, uint &penalty);
+  bool set_new_config_penalty(HNode *S, LNode *M, Config &Q_to, uint &penalty,
+                              std::vector<int> &cover);
   HNode *create_highlevel_node_penalty(const Config &Q, HNode *parent, uint penalty);
   void rewrite(HNode *H_from, HNode *H_to);
   int get_edge_cost(const Config &C1, const Config &C2);
   Solution backtrack(HNode *H);
-  void apply_new_solution(const Solution &plan);
+  void apply_new_solution(const RefinerResult &result);
+  SnapshotPtr get_incumbent();
   void set_scatter();
   void set_pibt();
   void set_refiner();
-  Solution get_refined_plan(const Solution &plan_origin);
+  void submit_refiner(const SnapshotPtr &plan);
+  RefinerResult get_refined_plan(const SnapshotPtr &plan,
+                                 const int refiner_seed);
+  RefinerResult get_scheduled_refined_plan(const SnapshotPtr &plan,
+                                           const int refiner_seed);
   void update_checkpoints();
   void logging();
 };
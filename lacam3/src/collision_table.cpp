@@ -1,43 +1,63 @@
 #include "../include/collision_table.hpp"
 
-CollisionTable::CollisionTable(const Instance *ins)
-    : body(ins->G->size()),
+CollisionTable::CollisionTable(const Instance *ins,
+                               const bool _flg_safe_intervals)
+    : rows(ins->G->size(), {0, 0, 0}),
+      cells(),
+      occupied(),
+      overflow(),
+      overflow_free(-1),
       body_last(ins->G->size()),
       collision_cnt(0),
-      N(ins->N)
+      N(ins->N),
+      base(nullptr),
+      is_local_row(),
+      is_local_goal(),
+      flg_safe_intervals(_flg_safe_intervals),
+      safe_intervals(flg_safe_intervals ? ins->G->size() : 0),
+      safe_intervals_dirty(flg_safe_intervals ? ins->G->size() : 0, true)
+{
+}
+
+CollisionTable::CollisionTable(const CollisionTable *_base,
+                               const bool _flg_safe_intervals)
+    : rows(_base->rows.size(), {0, 0, 0}),
+      cells(),
+      occupied(),
+      overflow(),
+      overflow_free(-1),
+      body_last(_base->rows.size()),
+      collision_cnt(_base->collision_cnt),
+      N(_base->N),
+      base(_base),
+      is_local_row(_base->rows.size(), false),
+      is_local_goal(_base->rows.size(), false),
+      flg_safe_intervals(_flg_safe_intervals),
+      safe_intervals(flg_safe_intervals ? _base->rows.size() : 0),
+      safe_intervals_dirty(flg_safe_intervals ? _base->rows.size() : 0, true)
 {
 }
 
 CollisionTable::~CollisionTable() {}
 
 int CollisionTable::getCollisionCost(const Vertex *v_from, const Vertex *v_to,
-                                     const int t_from)
+                                     const int t_from) const
 {
   const int t_to = t_from + 1;
   auto collision = 0;
   // vertex collision
-  if (t_to < body[v_to->id].size()) {
-    collision += body[v_to->id][t_to].size();
-  }
+  collision += getOccupancy(v_to->id, t_to);
   // edge collision
-  if (t_to < body[v_from->id].size() && t_from < body[v_to->id].size()) {
-    for (auto j : body[v_from->id][t_to]) {
-      for (auto k : body[v_to->id][t_from]) {
-        if (j == k) ++collision;
-      }
-    }
-  }
+  collision += getMoveCount(v_to->id, v_from->id, t_to);
   // goal collision
-  for (auto last_timestep : body_last[v_to->id]) {
-    if (t_to > last_timestep) ++collision;
-  }
+  collision += getGoalCount(v_to->id, t_to);
   return collision;
 }
 
 void CollisionTable::enrollPath(const int i, Path &path)
 {
   if (path.empty()) return;
-  const auto T_i = path.size() - 1;
+  const int T_i = path.size() - 1;
   for (auto t = 0; t <= T_i; ++t) {
     auto v = path[t];
 
@@ -45,52 +65,339 @@ void CollisionTable::enrollPath(const int i, Path &path)
     if (t > 0) collision_cnt += getCollisionCost(path[t - 1], path[t], t - 1);
 
     // register
-    while (body[v->id].size() <= t) body[v->id].emplace_back();
-    body[v->id][t].push_back(i);
+    insertAgent(v->id, t, i, (t > 0) ? path[t - 1]->id : -1);
   }
 
   // goal
-  body_last[path.back()->id].push_back(T_i);
-  auto &&entry = body[path.back()->id];
-  for (auto t = T_i + 1; t < entry.size(); ++t) {
-    collision_cnt += entry[t].size();
+  const auto g_id = path.back()->id;
+  if (flg_safe_intervals) safe_intervals_dirty[g_id] = true;
+  auto &&entry_last = detachGoalEntries(g_id);
+  entry_last.insert(std::upper_bound(entry_last.begin(), entry_last.end(),
+                                     std::make_pair(T_i, i)),
+                    std::make_pair(T_i, i));
+  const auto len = getRowLength(g_id);
+  for (auto t = getNextOccupiedTime(g_id, T_i + 1); t < len;
+       t = getNextOccupiedTime(g_id, t + 1)) {
+    collision_cnt += getOccupancy(g_id, t);
   }
 }
 
 void CollisionTable::clearPath(const int i, Path &path)
 {
   if (path.empty()) return;
-  const auto T_i = (int)path.size() - 1;
+  const int T_i = path.size() - 1;
   for (auto t = 0; t <= T_i; ++t) {
-    auto v = path[t];
-    auto &&entry = body[v->id][t];
-
     // remove entry
-    for (auto itr = entry.begin(); itr != entry.end();) {
-      if (*itr == i) {
-        entry.erase(itr);
-        break;
-      } else {
-        ++itr;
-      }
-    }
+    removeAgent(path[t]->id, t, i);
 
     // update collision count
     if (t > 0) collision_cnt -= getCollisionCost(path[t - 1], path[t], t - 1);
   }
 
   // goal
-  auto &&entry_body_last = body_last[path.back()->id];
+  const auto g_id = path.back()->id;
+  if (flg_safe_intervals) safe_intervals_dirty[g_id] = true;
+  auto &&entry_body_last = detachGoalEntries(g_id);
   for (auto itr = entry_body_last.begin(); itr != entry_body_last.end();) {
-    if (*itr == T_i) {
+    if (itr->second == i) {
       entry_body_last.erase(itr);
       break;
     } else {
       ++itr;
     }
   }
-  auto &&entry_body = body[path.back()->id];
-  for (auto t = T_i + 1; t < entry_body.size(); ++t) {
-    collision_cnt -= entry_body[t].size();
+  const auto len = getRowLength(g_id);
+  for (auto t = getNextOccupiedTime(g_id, T_i + 1); t < len;
+       t = getNextOccupiedTime(g_id, t + 1)) {
+    collision_cnt -= getOccupancy(g_id, t);
+  }
+}
+
+void CollisionTable::getCollidingAgents(const int i, const Path &path,
+                                        std::vector<int> &agents) const
+{
+  if (path.empty()) return;
+  const int T_i = path.size() - 1;
+  for (auto t = 0; t <= T_i; ++t) {
+    const auto v_id = path[t]->id;
+    // vertex collision
+    forEachAgent(v_id, t, [&](const int j) {
+      if (j != i) agents.push_back(j);
+    });
+    // edge collision
+    if (t > 0 && getMoveCount(v_id, path[t - 1]->id, t) > 0) {
+      auto &table = getTable(path[t - 1]->id);
+      auto &cell = table.cells[table.rows[path[t - 1]->id].offset + t];
+      if (cell.from == v_id && cell.agent != i) agents.push_back(cell.agent);
+      for (auto l = cell.next; l != -1; l = table.overflow[l].next) {
+        auto &&link = table.overflow[l];
+        if (link.from == v_id && link.agent != i) agents.push_back(link.agent);
+      }
+    }
+    // goal collision, passing others' goals
+    for (auto &&entry_last : getGoalEntries(v_id)) {
+      if (t <= entry_last.first) break;
+      if (entry_last.second != i) agents.push_back(entry_last.second);
+    }
+  }
+  // goal collision, others passing the goal
+  const auto g_id = path.back()->id;
+  const auto len = getRowLength(g_id);
+  for (auto t = getNextOccupiedTime(g_id, T_i + 1); t < len;
+       t = getNextOccupiedTime(g_id, t + 1)) {
+    forEachAgent(g_id, t, [&](const int j) { agents.push_back(j); });
+  }
+}
+
+void CollisionTable::computeSafeIntervals(const int v_id,
+                                          SIs &intervals) const
+{
+  intervals.clear();
+  const auto t_last = getGoalTime(v_id);
+  auto time_start = 0;
+  for (auto t = getNextOccupiedTime(v_id, 0); t < INT_MAX;
+       t = getNextOccupiedTime(v_id, t + 1)) {
+    auto time_end = t - 1;
+    if (time_start <= time_end) intervals.emplace_back(time_start, time_end);
+    time_start = t + 1;
+    if (t_last == t) break;
+  }
+  // add last safe interval
+  if (t_last == INT_MAX) intervals.emplace_back(time_start, INT_MAX - 1);
+}
+
+const SIs &CollisionTable::getSafeIntervals(const int v_id)
+{
+  if (safe_intervals_dirty[v_id]) {
+    computeSafeIntervals(v_id, safe_intervals[v_id]);
+    safe_intervals_dirty[v_id] = false;
+  }
+  return safe_intervals[v_id];
+}
+
+int CollisionTable::getNextOccupiedTime(const int v_id, const int t) const
+{
+  auto &table = getTable(v_id);
+  auto &row = table.rows[v_id];
+  if (t >= row.length) return INT_MAX;
+  auto k = row.offset + std::max(t, 0);
+  const auto k_end = row.offset + row.length;
+  auto word = table.occupied[k >> 6] & (~uint64_t(0) << (k & 63));
+  while (true) {
+    if (word != 0) {
+      k = (k & ~63) + __builtin_ctzll(word);
+      return (k < k_end) ? k - row.offset : INT_MAX;
+    }
+    k = (k & ~63) + 64;
+    if (k >= k_end) return INT_MAX;
+    word = table.occupied[k >> 6];
+  }
+}
+
+int CollisionTable::getNextFreeTime(const int v_id, const int t) const
+{
+  auto &table = getTable(v_id);
+  auto &row = table.rows[v_id];
+  if (t >= row.length) return t;
+  auto k = row.offset + std::max(t, 0);
+  const auto k_end = row.offset + row.length;
+  auto word = ~table.occupied[k >> 6] & (~uint64_t(0) << (k & 63));
+  while (true) {
+    if (word != 0) {
+      k = (k & ~63) + __builtin_ctzll(word);
+      return std::min(k, k_end) - row.offset;
+    }
+    k = (k & ~63) + 64;
+    if (k >= k_end) return row.length;
+    word = ~table.occupied[k >> 6];
+  }
+}
+
+int CollisionTable::getPrevFreeTime(const int v_id, const int t) const
+{
+  auto &table = getTable(v_id);
+  auto &row = table.rows[v_id];
+  if (t < 0) return -1;
+  if (t >= row.length) return t;
+  auto k = row.offset + t;
+  auto word = ~table.occupied[k >> 6] & (~uint64_t(0) >> (63 - (k & 63)));
+  while (true) {
+    if (word != 0) {
+      k = (k & ~63) + 63 - __builtin_clzll(word);
+      return (k >= row.offset) ? k - row.offset : -1;
+    }
+    k = (k & ~63) - 1;
+    if (k < row.offset) return -1;
+    word = ~table.occupied[k >> 6];
+  }
+}
+
+int CollisionTable::getEarliestFreeMove(const int v_from_id, const int v_to_id,
+                                        const int t_lo, const int t_hi) const
+{
+  const auto t_goal = getGoalTime(v_to_id);
+  auto t = t_lo;
+  while (t <= t_hi) {
+    // skip vertex collisions
+    t = getNextFreeTime(v_to_id, t + 1) - 1;
+    if (t > t_hi || t >= t_goal) break;
+    // edge collision
+    if (getMoveCount(v_to_id, v_from_id, t + 1) == 0) return t;
+    ++t;
+  }
+  return INT_MAX;
+}
+
+int CollisionTable::getLatestFreeMove(const int v_from_id, const int v_to_id,
+                                      const int t_lo, const int t_hi) const
+{
+  const auto t_goal = getGoalTime(v_to_id);
+  auto t = t_hi;
+  while (t >= t_lo) {
+    // goal collision
+    if (t >= t_goal) {
+      t = t_goal - 1;
+      continue;
+    }
+    // skip vertex collisions
+    t = getPrevFreeTime(v_to_id, t + 1) - 1;
+    if (t < t_lo) break;
+    // edge collision
+    if (getMoveCount(v_to_id, v_from_id, t + 1) == 0) return t;
+    --t;
+  }
+  return -1;
+}
+
+void CollisionTable::detachRow(const int v_id)
+{
+  if (base == nullptr || is_local_row[v_id]) return;
+  is_local_row[v_id] = true;
+  auto &row_base = base->rows[v_id];
+  auto &row = rows[v_id];
+  row = {(int)cells.size(), row_base.capacity, row_base.length};
+  cells.resize(row.offset + row.capacity, {0, -1, -1, -1});
+  occupied.resize((row.offset + row.capacity) >> 6, 0);
+  for (auto k = 0; k < row.capacity; ++k) {
+    auto &cell = cells[row.offset + k];
+    cell = base->cells[row_base.offset + k];
+    // copy linked agents
+    auto l_prev = -1;
+    for (auto l = cell.next; l != -1; l = base->overflow[l].next) {
+      const auto l_new = newLink();
+      overflow[l_new] = {base->overflow[l].agent, base->overflow[l].from, -1};
+      if (l_prev == -1) {
+        cell.next = l_new;
+      } else {
+        overflow[l_prev].next = l_new;
+      }
+      l_prev = l_new;
+    }
+  }
+  for (auto w = 0; w < (row.capacity >> 6); ++w) {
+    occupied[(row.offset >> 6) + w] =
+        base->occupied[(row_base.offset >> 6) + w];
+  }
+}
+
+CollisionTable::GoalEntries &CollisionTable::detachGoalEntries(const int v_id)
+{
+  if (base != nullptr && !is_local_goal[v_id]) {
+    is_local_goal[v_id] = true;
+    body_last[v_id] = base->body_last[v_id];
+  }
+  return body_last[v_id];
+}
+
+int CollisionTable::newLink()
+{
+  auto l = overflow_free;
+  if (l == -1) {
+    l = overflow.size();
+    overflow.emplace_back();
+  } else {
+    overflow_free = overflow[l].next;
+  }
+  return l;
+}
+
+void CollisionTable::reserve(const int v_id, const int t)
+{
+  detachRow(v_id);
+  auto &row = rows[v_id];
+  if (t >= row.length) row.length = t + 1;
+  if (t < row.capacity) return;
+
+  // move the row to the end of the arena, the old space is abandoned
+  auto capacity = std::max(64, row.capacity * 2);
+  while (capacity <= t) capacity *= 2;
+  const int offset = cells.size();
+  cells.resize(offset + capacity, {0, -1, -1, -1});
+  occupied.resize((offset + capacity) >> 6, 0);
+  for (auto k = 0; k < row.capacity; ++k) {
+    cells[offset + k] = cells[row.offset + k];
+  }
+  for (auto w = 0; w < (row.capacity >> 6); ++w) {
+    occupied[(offset >> 6) + w] = occupied[(row.offset >> 6) + w];
+  }
+  row.offset = offset;
+  row.capacity = capacity;
+}
+
+void CollisionTable::insertAgent(const int v_id, const int t, const int i,
+                                 const int from_id)
+{
+  reserve(v_id, t);
+  if (flg_safe_intervals) safe_intervals_dirty[v_id] = true;
+  const auto k = rows[v_id].offset + t;
+  auto &cell = cells[k];
+  if (cell.cnt == 0) {
+    cell.agent = i;
+    cell.from = from_id;
+    occupied[k >> 6] |= uint64_t(1) << (k & 63);
+  } else {
+    const auto l = newLink();
+    overflow[l] = {i, from_id, cell.next};
+    cell.next = l;
+  }
+  ++cell.cnt;
+}
+
+void CollisionTable::removeAgent(const int v_id, const int t, const int i)
+{
+  if (getOccupancy(v_id, t) == 0) return;
+  detachRow(v_id);
+  if (flg_safe_intervals) safe_intervals_dirty[v_id] = true;
+  const auto k = rows[v_id].offset + t;
+  auto &cell = cells[k];
+
+  // find the link of agent-i, or the first link to be moved into the cell
+  auto l_prev = -1;
+  auto l = cell.next;
+  if (cell.agent != i) {
+    while (l != -1 && overflow[l].agent != i) {
+      l_prev = l;
+      l = overflow[l].next;
+    }
+    if (l == -1) return;
+  } else if (l == -1) {
+    cell.agent = -1;
+    cell.from = -1;
+    occupied[k >> 6] &= ~(uint64_t(1) << (k & 63));
+    --cell.cnt;
+    return;
+  } else {
+    cell.agent = overflow[l].agent;
+    cell.from = overflow[l].from;
+  }
+
+  // release the link
+  if (l_prev == -1) {
+    cell.next = overflow[l].next;
+  } else {
+    overflow[l_prev].next = overflow[l].next;
   }
+  overflow[l].next = overflow_free;
+  overflow_free = l;
+  --cell.cnt;
 }
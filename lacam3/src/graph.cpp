@@ -1,7 +1,13 @@
 #include "../include/graph.hpp"
 
 Vertex::Vertex(int _id, int _index, int _x, int _y)
-    : id(_id), index(_index), x(_x), y(_y), neighbor()
+    : id(_id),
+      index(_index),
+      x(_x),
+      y(_y),
+      neighbor(),
+      corridor_id(-1),
+      corridor_pos(-1)
 {
 }
 
@@ -89,10 +95,64 @@ Graph::Graph(const std::string &filename) : V(Vertices()), width(0), height(0)
       }
     }
   }
+
+  setup_corridors();
 }
 
 int Graph::size() const { return V.size(); }
 
+void Graph::setup_corridors()
+{
+  corridors.clear();
+  for (auto v : V) v->corridor_id = v->corridor_pos = -1;
+
+  auto is_inner = [](Vertex *v) { return v->neighbor.size() == 2; };
+  auto next = [](Vertex *v, Vertex *v_prev) {
+    return (v->neighbor[0] == v_prev) ? v->neighbor[1] : v->neighbor[0];
+  };
+  auto visited = std::vector<bool>(V.size(), false);
+
+  for (auto v : V) {
+    if (!is_inner(v) || visited[v->id]) continue;
+
+    // find one end of the chain
+    auto u_prev = v;
+    auto u = v->neighbor[0];
+    while (is_inner(u) && u != v) {
+      auto w = next(u, u_prev);
+      u_prev = u;
+      u = w;
+    }
+    if (u == v) {
+      // isolated cycle of degree-2 vertices, left unlabeled
+      do {
+        visited[u->id] = true;
+        auto w = next(u, u_prev);
+        u_prev = u;
+        u = w;
+      } while (u != v);
+      continue;
+    }
+
+    // walk to the other end
+    const int c = corridors.size();
+    corridors.emplace_back();
+    auto &chain = corridors.back();
+    auto w_prev = u;
+    u = u_prev;
+    while (true) {
+      visited[u->id] = true;
+      u->corridor_id = c;
+      u->corridor_pos = chain.size();
+      chain.push_back(u);
+      auto w = next(u, w_prev);
+      if (!is_inner(w)) break;
+      w_prev = u;
+      u = w;
+    }
+  }
+}
+
 bool is_same_config(const Config &C1, const Config &C2)
 {
   const auto N = C1.size();
@@ -11,6 +11,8 @@ HNode::HNode(Config _C, DistTable *D, HNode *_parent, int _g, int _h)
       g(_g),
       h(_h),
       f(g + h),
+      penalty(-1),
+      mvc_cover(),
       priorities(C.size(), 0),
       order(C.size(), 0),
       search_tree(std::queue<LNode *>())
@@ -13,7 +13,8 @@ PIBT::PIBT(const Instance *_ins, DistTable *_D, int seed, bool _flg_swap,
       C_next(N, std::array<Vertex *, 5>()),
       tie_breakers(V_size, 0),
       flg_swap(_flg_swap),
-      scatter(_scatter)
+      scatter(_scatter),
+      scatter_hints(N, 0)
 {
 }
 
@@ -70,10 +71,7 @@ bool PIBT::funcPIBT(const int i, const Config &Q_from, Config &Q_to)
   // exploit scatter data
   Vertex *prioritized_vertex = nullptr;
   if (scatter != nullptr) {
-    auto itr_s = scatter->scatter_data[i].find(Q_from[i]->id);
-    if (itr_s != scatter->scatter_data[i].end()) {
-      prioritized_vertex = itr_s->second;
-    }
+    prioritized_vertex = scatter->get_next(i, Q_from[i], scatter_hints[i]);
   }
 
   // set C_next
@@ -181,7 +179,12 @@ bool PIBT::is_swap_required(const int pusher, const int puller,
   auto v_pusher = v_pusher_origin;
   auto v_puller = v_puller_origin;
   Vertex *tmp = nullptr;
+  const auto c_goal = ins->goals[pusher]->corridor_id;
   while (D->get(pusher, v_puller) < D->get(pusher, v_pusher)) {
+    // distances strictly decrease along the corridor unless it has the goal
+    if (c_goal == -1 || c_goal != v_puller->corridor_id) {
+      skip_corridor(v_pusher, v_puller);
+    }
     auto n = v_puller->neighbor.size();
     // remove agents who need not to move
     for (auto u : v_puller->neighbor) {
@@ -210,7 +213,11 @@ bool PIBT::is_swap_possible(Vertex *v_pusher_origin, Vertex *v_puller_origin)
   auto v_pusher = v_pusher_origin;
   auto v_puller = v_puller_origin;
   Vertex *tmp = nullptr;
+  const auto c_origin = v_pusher_origin->corridor_id;
   while (v_puller != v_pusher_origin) {  // avoid loop
+    if (c_origin == -1 || c_origin != v_puller->corridor_id) {
+      skip_corridor(v_pusher, v_puller);
+    }
     auto n = v_puller->neighbor.size();
     for (auto u : v_puller->neighbor) {
       const auto i = occupied_now[u->id];
@@ -228,3 +235,27 @@ bool PIBT::is_swap_possible(Vertex *v_pusher_origin, Vertex *v_puller_origin)
   }
   return false;
 }
+
+void PIBT::skip_corridor(Vertex *&v_pusher, Vertex *&v_puller)
+{
+  // inside a corridor, the pull simply proceeds to the next vertex
+  const auto c = v_puller->corridor_id;
+  if (c == -1) return;
+  auto &chain = ins->G->corridors[c];
+  const int p = v_puller->corridor_pos;
+  const int L = chain.size();
+  int dir;
+  if (v_pusher->corridor_id == c) {
+    dir = p - v_pusher->corridor_pos;
+  } else if (p == 0) {
+    dir = 1;
+  } else if (p == L - 1) {
+    dir = -1;
+  } else {
+    return;
+  }
+  const auto p_end = (dir > 0) ? L - 1 : 0;
+  if (p == p_end) return;
+  v_pusher = chain[p_end - dir];
+  v_puller = chain[p_end];
+}
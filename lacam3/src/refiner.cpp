@@ -1,43 +1,289 @@
 #include "../include/refiner.hpp"
 
+const char *REFINER_NEIGHBOR_NAMES[NB_NUM] = {"random", "delay", "intersection",
+                                              "region"};
+
+namespace
+{
+
+// append agents visiting v in [t_from, t_to], except marked ones
+void collect_agents_at(const CollisionTable &CT, const Vertex *v,
+                       const int t_from, const int t_to, const int num,
+                       std::vector<int> &agents, std::vector<bool> &marked)
+{
+  auto add = [&](const int j) {
+    if ((int)agents.size() >= num || marked[j]) return;
+    marked[j] = true;
+    agents.push_back(j);
+  };
+  const auto len = std::min(CT.getRowLength(v->id), t_to + 1);
+  for (auto t = CT.getNextOccupiedTime(v->id, t_from); t < len;
+       t = CT.getNextOccupiedTime(v->id, t + 1)) {
+    CT.forEachAgent(v->id, t, add);
+  }
+  for (auto &&entry_last : CT.getGoalEntries(v->id)) {
+    if (entry_last.first > t_to) break;
+    add(entry_last.second);
+  }
+}
+
+// agents around v, expanding the region by BFS
+void collect_agents_around(const CollisionTable &CT, Vertex *v_center,
+                           const int num, std::vector<int> &agents,
+                           std::vector<bool> &marked, std::mt19937 &MT)
+{
+  auto OPEN = std::queue<Vertex *>();
+  auto CLOSED = std::vector<bool>(CT.rows.size(), false);
+  OPEN.push(v_center);
+  CLOSED[v_center->id] = true;
+  auto C = Vertices();
+  while (!OPEN.empty() && (int)agents.size() < num) {
+    auto v = OPEN.front();
+    OPEN.pop();
+    collect_agents_at(CT, v, 0, INT_MAX - 1, num, agents, marked);
+    C = v->neighbor;
+    std::shuffle(C.begin(), C.end(), MT);
+    for (auto u : C) {
+      if (CLOSED[u->id]) continue;
+      CLOSED[u->id] = true;
+      OPEN.push(u);
+    }
+  }
+}
+
+// the number of timesteps when v is occupied
+int get_traffic(const CollisionTable &CT, const Vertex *v)
+{
+  auto cnt = 0;
+  const auto len = CT.getRowLength(v->id);
+  for (auto t = CT.getNextOccupiedTime(v->id, 0); t < len;
+       t = CT.getNextOccupiedTime(v->id, t + 1)) {
+    ++cnt;
+  }
+  return cnt;
+}
+
+}  // namespace
+
+RefinerStats::RefinerStats()
+    : weights(NB_NUM, 1.0), iter(NB_NUM, 0), gain(NB_NUM, 0), ms(NB_NUM, 0)
+{
+}
+
+std::vector<double> RefinerStats::get_weights()
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return weights;
+}
+
+void RefinerStats::update(const std::vector<double> &_weights,
+                          const std::vector<int> &_iter,
+                          const std::vector<int> &_gain,
+                          const std::vector<double> &_ms)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  for (auto nb = 0; nb < NB_NUM; ++nb) {
+    // other refiners may have updated weights meanwhile
+    weights[nb] = (weights[nb] + _weights[nb]) / 2;
+    iter[nb] += _iter[nb];
+    gain[nb] += _gain[nb];
+    ms[nb] += _ms[nb];
+  }
+}
+
+RefinerScheduler::RefinerScheduler(const bool flg_recursive,
+                                   const bool flg_iterative)
+    : arms()
+{
+  if (flg_recursive) arms.push_back({0, 0, 0, 0, 0, 0});
+  if (flg_iterative) {
+    for (auto size : {2, 4, 8, 16, 32}) arms.push_back({size, 0, 0, 0, 0, 0});
+  }
+}
+
+int RefinerScheduler::select(std::mt19937 &MT, const bool flg_recursive)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  auto candidates = std::vector<int>();
+  for (auto k = 0; k < (int)arms.size(); ++k) {
+    if (arms[k].size > 0 || flg_recursive) candidates.push_back(k);
+  }
+  if (candidates.empty()) return -1;
+
+  // untried arms first, then exploration or exploitation
+  for (auto k : candidates) {
+    if (arms[k].pulls == 0) {
+      ++arms[k].pulls;
+      return k;
+    }
+  }
+  auto k_best = candidates[get_random_int(MT, 0, candidates.size() - 1)];
+  if (get_random_float(MT) >= REFINER_SCHEDULER_EPSILON) {
+    for (auto k : candidates) {
+      if (arms[k].score > arms[k_best].score) k_best = k;
+    }
+  }
+  ++arms[k_best].pulls;
+  return k_best;
+}
+
+void RefinerScheduler::update(const int k, const int gain, const double ms)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  auto &arm = arms[k];
+  arm.gain += gain;
+  arm.ms += ms;
+  const auto score = gain / std::max(ms, 0.001);
+  arm.score = (++arm.updates == 1)
+                  ? score
+                  : REFINER_SCHEDULER_REACTION * score +
+                        (1 - REFINER_SCHEDULER_REACTION) * arm.score;
+}
+
+std::string RefinerScheduler::get_name(const int k) const
+{
+  return arms[k].size == 0 ? "recursive"
+                           : "iterative-" + std::to_string(arms[k].size);
+}
+
 Solution refine(const Instance *ins, const Deadline *deadline,
                 const Solution &solution, DistTable *D, const int seed,
-                const int verbose)
+                const int verbose, const int neighbor, RefinerStats *stats,
+                const int neighbor_size)
 {
   if (solution.empty()) return Solution();
+  auto res = refine(ins, deadline, *Snapshot::from_configs(solution), D, seed,
+                    verbose, neighbor, stats, neighbor_size);
+  return (res == nullptr) ? Solution() : res->get_solution(ins->G);
+}
+
+SnapshotPtr refine(const Instance *ins, const Deadline *deadline,
+                   const Snapshot &solution, DistTable *D, const int seed,
+                   const int verbose, const int neighbor, RefinerStats *stats,
+                   const int neighbor_size)
+{
   info(0, verbose, deadline, "refiner-", seed, "\tactivated");
   // setup
   const auto N = ins->N;
   auto MT = std::mt19937(seed);
-  auto paths = translateConfigsToPaths(solution);
-  auto cost_before = get_sum_of_loss_paths(paths);
+  // paths are materialized when touched, others stay in the snapshot
+  auto paths = Paths(N);
+  auto get_path = [&](const int i) -> Path & {
+    if (paths[i].empty()) solution.get_path(i, ins->G, paths[i]);
+    return paths[i];
+  };
+  const auto cost_before = solution.get_sum_of_loss();
+  auto cost_after = cost_before;
   std::vector<int> order(N, 0);
   std::iota(order.begin(), order.end(), 0);
-  auto CT = CollisionTable(ins);
-  for (auto i = 0; i < N; ++i) CT.enrollPath(i, paths[i]);
+  // copy-on-write overlay of the shared table, with safe interval index
+  auto CT = CollisionTable(solution.get_collision_table(ins), true);
   std::shuffle(order.begin(), order.end(), MT);
 
-  const auto num_refine_agents =
-      std::max(1, std::min(get_random_int(MT, 1, 30), int(N / 4)));
+  const auto num_refine_agents = std::max(
+      1, std::min(neighbor_size > 0 ? neighbor_size : get_random_int(MT, 1, 30),
+                  int(N / 4)));
   info(1, verbose, deadline, "refiner-", seed,
        "\tsize of modif set: ", num_refine_agents);
+
+  // neighborhood generators, chosen adaptively by gain per ms
+  auto weights = (stats != nullptr) ? stats->get_weights()
+                                     : std::vector<double>(NB_NUM, 1.0);
+  auto stats_iter = std::vector<int>(NB_NUM, 0);
+  auto stats_gain = std::vector<int>(NB_NUM, 0);
+  auto stats_ms = std::vector<double>(NB_NUM, 0);
+  auto agents = std::vector<int>();
+  auto marked = std::vector<bool>(N, false);
+  auto tabu = std::vector<bool>(N, false);  // seeds of delay-based ones
+  auto delays = std::vector<int>(N, 0);
+  for (uint i = 0; i < N; ++i) {
+    delays[i] = solution.get_path_loss(i) - D->get(i, ins->starts[i]);
+  }
+
   for (auto k = 0; (k + 1) * num_refine_agents < N; ++k) {
-    if (is_expired(deadline)) return Solution();
+    if (is_expired(deadline)) return nullptr;
+    const auto t_start = Time::now();
+
+    // select agents
+    auto nb = neighbor;
+    if (nb == NB_ADAPTIVE) {
+      nb = std::discrete_distribution<int>(weights.begin(), weights.end())(MT);
+    }
+    agents.clear();
+    if (nb == NB_DELAY) {
+      // the most delayed agent and agents on its shortest path
+      auto i_max = -1;
+      auto d_max = 0;
+      for (uint i = 0; i < N; ++i) {
+        if (tabu[i] || delays[i] <= d_max) continue;
+        d_max = delays[i];
+        i_max = i;
+      }
+      if (i_max == -1) {
+        // all delayed agents have been tried
+        tabu.assign(N, false);
+        i_max = order[get_random_int(MT, 0, N - 1)];
+      }
+      tabu[i_max] = true;
+      marked[i_max] = true;
+      agents.push_back(i_max);
+      auto v = ins->starts[i_max];
+      for (auto t = 0; (int)agents.size() < num_refine_agents; ++t) {
+        collect_agents_at(CT, v, t - REFINER_DELAY_WINDOW,
+                          t + REFINER_DELAY_WINDOW, num_refine_agents, agents,
+                          marked);
+        if (v == ins->goals[i_max]) break;
+        for (auto u : v->neighbor) {
+          if (D->get(i_max, u) < D->get(i_max, v)) {
+            v = u;
+            break;
+          }
+        }
+      }
+    } else if (nb == NB_INTERSECTION) {
+      // the busiest among sampled intersections
+      Vertex *v_center = nullptr;
+      auto traffic_max = -1;
+      for (auto _k = 0; _k < 8; ++_k) {
+        auto &path = get_path(get_random_int(MT, 0, N - 1));
+        auto v = path[get_random_int(MT, 0, path.size() - 1)];
+        if (v->neighbor.size() < 3 && v_center != nullptr) continue;
+        const auto traffic = get_traffic(CT, v);
+        if (traffic > traffic_max) {
+          traffic_max = traffic;
+          v_center = v;
+        }
+      }
+      collect_agents_around(CT, v_center, num_refine_agents, agents, marked,
+                            MT);
+    } else if (nb == NB_REGION) {
+      // agents passing a random region
+      auto v_center = ins->G->V[get_random_int(MT, 0, ins->G->size() - 1)];
+      collect_agents_around(CT, v_center, num_refine_agents, agents, marked,
+                            MT);
+    } else {
+      // disjoint chunks of a random order
+      for (auto _i = 0; _i < num_refine_agents; ++_i) {
+        agents.push_back(order[k * num_refine_agents + _i]);
+      }
+    }
+    for (auto i : agents) marked[i] = false;
+    if (agents.empty()) continue;
+    const int num_agents = agents.size();
 
     auto old_cost = 0;
     auto new_cost = 0;
 
     // compute old cost
-    for (auto _i = 0; _i < num_refine_agents; ++_i) {
-      const auto i = order[k * num_refine_agents + _i];
-      old_cost += get_path_loss(paths[i]);
+    for (auto i : agents) {
+      old_cost += get_path_loss(get_path(i));
       CT.clearPath(i, paths[i]);
     }
 
     // re-planning
-    Paths new_paths(num_refine_agents);
-    for (auto _i = 0; _i < num_refine_agents; ++_i) {
-      const auto i = order[k * num_refine_agents + _i];
+    Paths new_paths(num_agents);
+    for (auto _i = 0; _i < num_agents; ++_i) {
+      const auto i = agents[_i];
       // note: I also tested A*, but SIPP was better
       new_paths[_i] = sipp(i, ins->starts[i], ins->goals[i], D, &CT, deadline,
                            old_cost - new_cost - 1);
@@ -46,24 +292,49 @@ Solution refine(const Instance *ins, const Deadline *deadline,
       CT.enrollPath(i, new_paths[_i]);
     }
 
-    if (!new_paths[num_refine_agents - 1].empty() && new_cost <= old_cost) {
+    auto gain = 0;
+    if (!new_paths[num_agents - 1].empty() && new_cost <= old_cost) {
       // success
-      for (auto _i = 0; _i < num_refine_agents; ++_i) {
-        const auto i = order[k * num_refine_agents + _i];
+      for (auto _i = 0; _i < num_agents; ++_i) {
+        const auto i = agents[_i];
         paths[i] = new_paths[_i];
+        delays[i] = get_path_loss(paths[i]) - D->get(i, ins->starts[i]);
       }
+      gain = old_cost - new_cost;
+      cost_after -= gain;
     } else {
       // failure
-      for (auto _i = 0; _i < num_refine_agents; ++_i) {
-        const auto i = order[k * num_refine_agents + _i];
+      for (auto _i = 0; _i < num_agents; ++_i) {
+        const auto i = agents[_i];
         if (!new_paths[_i].empty()) CT.clearPath(i, new_paths[_i]);
         CT.enrollPath(i, paths[i]);
       }
     }
+
+    // update statistics
+    const auto ms =
+        std::chrono::duration<double, std::milli>(Time::now() - t_start)
+            .count();
+    ++stats_iter[nb];
+    stats_gain[nb] += gain;
+    stats_ms[nb] += ms;
+    weights[nb] = std::max(
+        0.01, REFINER_REACTION * gain / std::max(ms, 0.001) +
+                  (1 - REFINER_REACTION) * weights[nb]);
   }
 
+  if (stats != nullptr) {
+    stats->update(weights, stats_iter, stats_gain, stats_ms);
+  }
+  for (auto nb = 0; nb < NB_NUM; ++nb) {
+    if (stats_iter[nb] == 0) continue;
+    info(1, verbose, deadline, "refiner-", seed, "\t",
+         REFINER_NEIGHBOR_NAMES[nb], ": iter=", stats_iter[nb],
+         " gain=", stats_gain[nb], " ms=", stats_ms[nb],
+         " gain/ms=", stats_gain[nb] / std::max(stats_ms[nb], 0.001));
+  }
   info(0, verbose, deadline, "refiner-", seed, "\tsum_of_loss: ", cost_before,
-       " -> ", get_sum_of_loss_paths(paths));
+       " -> ", cost_after);
 
-  return translatePathsToConfigs(paths);
+  return Snapshot::from_paths(paths, &solution);
 }
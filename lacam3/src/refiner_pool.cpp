@@ -0,0 +1,74 @@
+#include "../include/refiner_pool.hpp"
+
+RefinerPool::RefinerPool(const int num_workers)
+    : workers(),
+      jobs(),
+      finished(),
+      num_running(0),
+      flg_stop(false),
+      flg_cancel(false)
+{
+  for (auto k = 0; k < num_workers; ++k) {
+    workers.emplace_back(&RefinerPool::work, this);
+  }
+}
+
+RefinerPool::~RefinerPool()
+{
+  cancel();
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    flg_stop = true;
+  }
+  cv_job.notify_all();
+  for (auto &th : workers) th.join();
+}
+
+void RefinerPool::submit(Job job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (flg_cancel) return;
+    jobs.push_back(std::move(job));
+  }
+  cv_job.notify_one();
+}
+
+bool RefinerPool::pop_finished(RefinerResult &result)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  if (finished.empty()) return false;
+  result = std::move(finished.front());
+  finished.pop_front();
+  return true;
+}
+
+void RefinerPool::cancel()
+{
+  std::unique_lock<std::mutex> lock(mtx);
+  flg_cancel = true;
+  jobs.clear();
+  cv_done.wait(lock, [&] { return num_running == 0; });
+}
+
+void RefinerPool::work()
+{
+  while (true) {
+    auto job = Job();
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv_job.wait(lock, [&] { return flg_stop || !jobs.empty(); });
+      if (flg_stop) return;
+      job = std::move(jobs.front());
+      jobs.pop_front();
+      ++num_running;
+    }
+    auto result = job();
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      finished.push_back(std::move(result));  // failures too
+      --num_running;
+    }
+    cv_done.notify_all();
+  }
+}
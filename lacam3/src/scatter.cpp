@@ -2,8 +2,120 @@
 
 #include "../include/metrics.hpp"
 
+ScatterWorkspace::ScatterWorkspace(const int V_size, const int _f_range)
+    : f_range(_f_range),
+      CLOSED(V_size, nullptr),
+      USED(),
+      nodes(),
+      buckets(),
+      size(0),
+      c_cur(0),
+      f_cur(0),
+      c_max(-1)
+{
+}
+
+void ScatterWorkspace::clear()
+{
+  for (auto k : USED) CLOSED[k] = nullptr;
+  USED.clear();
+  nodes.clear();
+  // buckets keep their capacity over searches
+  for (auto k = c_cur * f_range; k < (c_max + 1) * f_range; ++k) {
+    buckets[k].clear();
+  }
+  size = 0;
+  c_cur = 0;
+  f_cur = 0;
+  c_max = -1;
+}
+
+void ScatterWorkspace::push(const Node &n, const int f_offset)
+{
+  if (n.c > c_max) {
+    c_max = n.c;
+    const auto bucket_num = (size_t)(c_max + 1) * f_range;  // c_max >= 0
+    if (buckets.size() < bucket_num) buckets.resize(bucket_num);
+  }
+  buckets[n.c * f_range + f_offset].push_back(nodes.size());
+  nodes.push_back(n);
+  ++size;
+}
+
+ScatterWorkspace::Node ScatterWorkspace::pop()
+{
+  while (buckets[c_cur * f_range + f_cur].empty()) {
+    if (++f_cur == f_range) {
+      f_cur = 0;
+      ++c_cur;
+    }
+  }
+  auto &bucket = buckets[c_cur * f_range + f_cur];
+  auto k = bucket.back();
+  bucket.pop_back();
+  --size;
+  return nodes[k];
+}
+
+ScatterWorkers::ScatterWorkers(const int num_workers)
+    : threads(),
+      job(nullptr),
+      generation(0),
+      num_pending(0),
+      flg_stop(false)
+{
+  for (auto k = 1; k < num_workers; ++k) {
+    threads.emplace_back(&ScatterWorkers::work, this, k);
+  }
+}
+
+ScatterWorkers::~ScatterWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    flg_stop = true;
+  }
+  cv_start.notify_all();
+  for (auto &th : threads) th.join();
+}
+
+void ScatterWorkers::run(const std::function<void(int)> &fn)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    job = &fn;
+    num_pending = threads.size();
+    ++generation;
+  }
+  cv_start.notify_all();
+  fn(0);
+  std::unique_lock<std::mutex> lock(mtx);
+  cv_done.wait(lock, [&] { return num_pending == 0; });
+}
+
+void ScatterWorkers::work(const int k)
+{
+  auto generation_done = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv_start.wait(lock,
+                    [&] { return flg_stop || generation != generation_done; });
+      if (flg_stop) return;
+      generation_done = generation;
+    }
+    (*job)(k);
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (--num_pending > 0) continue;
+    }
+    cv_done.notify_one();
+  }
+}
+
 Scatter::Scatter(const Instance *_ins, DistTable *_D, const Deadline *_deadline,
-                 const int seed, int _verbose, int _cost_margin)
+                 const int seed, int _verbose, int _cost_margin,
+                 int _num_threads)
     : ins(_ins),
       deadline(_deadline),
       MT(std::mt19937(seed)),
@@ -13,9 +125,11 @@ Scatter::Scatter(const Instance *_ins, DistTable *_D, const Deadline *_deadline,
       T(get_makespan_lower_bound(*ins, *_D) + _cost_margin),
       D(_D),
       cost_margin(_cost_margin),
+      num_threads(std::max(1, _num_threads)),
       sum_of_path_length(0),
       paths(N),
-      scatter_data(N),
+      scatter_offsets(N + 1, 0),
+      scatter_data(),
       CT(ins)
 {
 }
@@ -24,124 +138,261 @@ void Scatter::construct()
 {
   info(0, verbose, deadline, "scatter", "\tinvoked");
 
-  // define path finding utilities
-  // vertex, cost-to-come, cost-to-go, collision, parent
-  using ScatterNode = std::tuple<Vertex *, int, int, int, Vertex *>;
-  auto cmp = [&](ScatterNode &a, ScatterNode &b) {
-    // collision
-    if (std::get<3>(a) != std::get<3>(b))
-      return std::get<3>(a) > std::get<3>(b);
-    auto f_a = std::get<1>(a) + std::get<2>(a);
-    auto f_b = std::get<1>(b) + std::get<2>(b);
-    if (f_a != f_b) return f_a > f_b;
-    return std::get<0>(a)->id < std::get<0>(b)->id;
-  };
-  auto CLOSED = std::vector<Vertex *>(V_size, nullptr);  // parent
+  // working memory for A*, one for each thread
+  auto W_pool = std::vector<ScatterWorkspace>(
+      num_threads, ScatterWorkspace(V_size, cost_margin + 1));
+  auto workers = ScatterWorkers(num_threads);  // started once for all batches
 
   // metrics
   auto collision_cnt_last = 0;
-  auto paths_prev = std::vector<Path>();
+
+  // agents to be replanned, all agents at first
+  auto order = std::vector<int>(N, 0);
+  std::iota(order.begin(), order.end(), 0);
+  auto in_worklist = std::vector<bool>(N, false);
+  auto colliding = std::vector<int>();
 
   // main loop
   auto loop = 0;
-  while (loop < 2 || CT.collision_cnt < collision_cnt_last) {
+  while (true) {
     ++loop;
     collision_cnt_last = CT.collision_cnt;
 
     // randomize planning order
-    auto order = std::vector<int>(N, 0);
-    std::iota(order.begin(), order.end(), 0);
     std::shuffle(order.begin(), order.end(), MT);
 
-    // single-agent path finding for agent-i
-    for (int _i = 0; _i < N; ++_i) {
-      if (is_expired(deadline)) break;
-
-      const auto i = order[_i];
-      const auto cost_ub = D->get(i, ins->starts[i]) + cost_margin;
-
-      if (!paths[i].empty()) sum_of_path_length -= (paths[i].size() - 1);
-
-      // clear cache
-      CT.clearPath(i, paths[i]);
-
-      // setup A*
-      auto OPEN = std::priority_queue<ScatterNode, std::vector<ScatterNode>,
-                                      decltype(cmp)>(cmp);
-      // used with CLOSED, vertex-id list
-      const auto s_i = ins->starts[i];
-      OPEN.push(std::make_tuple(s_i, 0, D->get(i, s_i), 0, nullptr));
-      auto USED = std::vector<int>();
-
-      // A*
-      auto solved = false;
-      while (!OPEN.empty() && !is_expired(deadline)) {
-        // pop
-        auto node = OPEN.top();
-        OPEN.pop();
-
-        // check CLOSED list
-        const auto v = std::get<0>(node);
-        const auto g_v = std::get<1>(node);  // cost-to-come
-        const auto c_v = std::get<3>(node);  // collision
-        if (CLOSED[v->id] != nullptr) continue;
-        CLOSED[v->id] = std::get<4>(node);  // parent
-        USED.push_back(v->id);
-
-        // check goal condition
-        if (v == ins->goals[i]) {
-          solved = true;
-          break;
-        }
-
-        // expand
-        for (auto u : v->neighbor) {
-          auto d_u = D->get(i, u);
-          if (u != s_i && CLOSED[u->id] == nullptr &&
-              d_u + g_v + 1 <= cost_ub) {
-            // insert new node
-            OPEN.push(std::make_tuple(u, g_v + 1, d_u,
-                                      CT.getCollisionCost(v, u, g_v) + c_v, v));
-          }
-        }
+    if (num_threads > 1) {
+      for (auto &batch : get_batches(order)) {
+        if (is_expired(deadline)) break;
+        replan_batch(batch, W_pool, workers);
       }
-
-      // backtrack
-      if (solved) {
-        paths[i].clear();
-        auto v = ins->goals[i];
-        while (v != nullptr) {
-          paths[i].push_back(v);
-          v = CLOSED[v->id];
-        }
-        std::reverse(paths[i].begin(), paths[i].end());
+    } else {
+      for (auto i : order) {
+        if (is_expired(deadline)) break;
+        replan(i, W_pool[0]);
       }
-
-      // register to CT & update collision count
-      CT.enrollPath(i, paths[i]);
-      sum_of_path_length += paths[i].size() - 1;
-
-      // memory management
-      for (auto k : USED) CLOSED[k] = nullptr;
     }
 
-    paths_prev = paths;
     info(1, verbose, deadline, "scatter", "\titer:", loop,
-         "\tcollision_cnt:", CT.collision_cnt);
+         "\treplanned:", order.size(), "\tcollision_cnt:", CT.collision_cnt);
 
     if (CT.collision_cnt == 0) break;
     if (is_expired(deadline)) break;
-  }
+    if (loop >= 2 && CT.collision_cnt >= collision_cnt_last) break;
 
-  paths = paths_prev;
+    // next worklist, only replanned agents can newly collide
+    auto worklist = std::vector<int>();
+    auto enqueue = [&](const int j) {
+      if (in_worklist[j]) return;
+      in_worklist[j] = true;
+      worklist.push_back(j);
+    };
+    for (auto i : order) {
+      colliding.clear();
+      CT.getCollidingAgents(i, paths[i], colliding);
+      if (colliding.empty()) continue;
+      enqueue(i);
+      for (auto j : colliding) enqueue(j);
+    }
+    for (auto i : worklist) in_worklist[i] = false;
+    if (worklist.empty()) break;
+    order.swap(worklist);
+  }
 
   // set scatter data
   for (auto i = 0; i < N; ++i) {
+    scatter_offsets[i] = scatter_data.size();
     if (paths[i].empty()) continue;
-    for (auto t = 0; t < paths[i].size() - 1; ++t) {
-      scatter_data[i][paths[i][t]->id] = paths[i][t + 1];
+    for (auto t = 0; t < (int)paths[i].size() - 1; ++t) {
+      scatter_data.emplace_back(paths[i][t]->id, t);
     }
+    std::sort(scatter_data.begin() + scatter_offsets[i], scatter_data.end());
   }
+  scatter_offsets[N] = scatter_data.size();
 
   info(0, verbose, deadline, "scatter", "\tcompleted");
 }
+
+void Scatter::replan(const int i, ScatterWorkspace &W)
+{
+  if (!paths[i].empty()) sum_of_path_length -= (paths[i].size() - 1);
+  CT.clearPath(i, paths[i]);
+
+  auto collision = 0;
+  auto path = find_path(i, W, collision);
+  if (!path.empty()) paths[i] = path;
+
+  // register to CT & update collision count
+  CT.enrollPath(i, paths[i]);
+  sum_of_path_length += paths[i].size() - 1;
+}
+
+void Scatter::replan_batch(const std::vector<int> &batch,
+                           std::vector<ScatterWorkspace> &W_pool,
+                           ScatterWorkers &workers)
+{
+  const int K = batch.size();
+  for (auto i : batch) {
+    if (!paths[i].empty()) sum_of_path_length -= (paths[i].size() - 1);
+    CT.clearPath(i, paths[i]);
+  }
+
+  // path finding against the same snapshot of CT, read-only here
+  auto new_paths = std::vector<Path>(K);
+  auto collisions = std::vector<int>(K, 0);
+  workers.run([&](const int k) {
+    for (auto j = k; j < K; j += num_threads) {
+      new_paths[j] = find_path(batch[j], W_pool[k], collisions[j]);
+    }
+  });
+
+  // commit, paths interfering with already committed ones are re-planned
+  for (auto j = 0; j < K; ++j) {
+    const auto i = batch[j];
+    if (!new_paths[j].empty() &&
+        get_path_collision(new_paths[j]) > collisions[j]) {
+      new_paths[j] = find_path(i, W_pool[0], collisions[j]);
+    }
+    if (!new_paths[j].empty()) paths[i] = new_paths[j];
+    CT.enrollPath(i, paths[i]);
+    sum_of_path_length += paths[i].size() - 1;
+  }
+}
+
+std::vector<std::vector<int>> Scatter::get_batches(std::vector<int> &order)
+{
+  // agents whose bounding boxes, extended by the cost margin, are disjoint
+  // rarely interfere with each other
+  struct Box {
+    int x_min, x_max, y_min, y_max;
+    bool overlaps(const Box &b) const
+    {
+      return x_min <= b.x_max && b.x_min <= x_max && y_min <= b.y_max &&
+             b.y_min <= y_max;
+    }
+  };
+  const auto m = cost_margin / 2 + 1;
+  auto boxes = std::vector<Box>(N);
+  for (auto i = 0; i < N; ++i) {
+    auto s = ins->starts[i];
+    auto g = ins->goals[i];
+    boxes[i] = {std::min(s->x, g->x) - m, std::max(s->x, g->x) + m,
+                std::min(s->y, g->y) - m, std::max(s->y, g->y) + m};
+  }
+
+  const int batch_size = num_threads * 4;
+  const int window = batch_size * 4;  // look-ahead in the order
+  auto batches = std::vector<std::vector<int>>();
+  auto rest = std::list<int>(order.begin(), order.end());
+  while (!rest.empty()) {
+    batches.emplace_back();
+    auto &batch = batches.back();
+    auto cnt = 0;
+    for (auto itr = rest.begin();
+         itr != rest.end() && cnt < window && (int)batch.size() < batch_size;
+         ++cnt) {
+      const auto i = *itr;
+      auto interfering = false;
+      for (auto j : batch) {
+        if (boxes[i].overlaps(boxes[j])) {
+          interfering = true;
+          break;
+        }
+      }
+      if (interfering) {
+        ++itr;
+      } else {
+        batch.push_back(i);
+        itr = rest.erase(itr);
+      }
+    }
+  }
+  return batches;
+}
+
+Path Scatter::find_path(const int i, ScatterWorkspace &W, int &collision)
+{
+  const auto s_i = ins->starts[i];
+  const auto f_min = D->get(i, s_i);
+  const auto cost_ub = f_min + cost_margin;
+  auto &CLOSED = W.CLOSED;
+
+  // setup A*
+  W.push({s_i, 0, 0, nullptr}, 0);
+
+  // A*
+  auto solved = false;
+  while (W.size > 0 && !is_expired(deadline)) {
+    // pop
+    const auto node = W.pop();
+
+    // check CLOSED list
+    const auto v = node.v;
+    const auto g_v = node.g;  // cost-to-come
+    const auto c_v = node.c;  // collision
+    if (CLOSED[v->id] != nullptr) continue;
+    CLOSED[v->id] = node.parent;
+    W.USED.push_back(v->id);
+
+    // check goal condition
+    if (v == ins->goals[i]) {
+      solved = true;
+      collision = c_v;
+      break;
+    }
+
+    // expand
+    for (auto u : v->neighbor) {
+      auto d_u = D->get(i, u);
+      if (u != s_i && CLOSED[u->id] == nullptr && d_u + g_v + 1 <= cost_ub) {
+        // insert new node
+        W.push({u, g_v + 1, CT.getCollisionCost(v, u, g_v) + c_v, v},
+               d_u + g_v + 1 - f_min);
+      }
+    }
+  }
+
+  // backtrack
+  auto path = Path();
+  if (solved) {
+    auto v = ins->goals[i];
+    while (v != nullptr) {
+      path.push_back(v);
+      v = CLOSED[v->id];
+    }
+    std::reverse(path.begin(), path.end());
+  }
+
+  // memory management
+  W.clear();
+
+  return path;
+}
+
+int Scatter::get_path_collision(const Path &path)
+{
+  auto collision = 0;
+  for (auto t = 1; t < (int)path.size(); ++t) {
+    collision += CT.getCollisionCost(path[t - 1], path[t], t - 1);
+  }
+  return collision;
+}
+
+Vertex *Scatter::get_next(const int i, const Vertex *v, int &hint) const
+{
+  auto &path = paths[i];
+  const int T_i = (int)path.size() - 1;
+
+  // agents usually follow their paths, check the hint first
+  if (0 <= hint && hint < T_i && path[hint] == v) return path[hint + 1];
+  if (0 <= hint + 1 && hint + 1 < T_i && path[hint + 1] == v) {
+    return path[++hint + 1];
+  }
+
+  auto first = scatter_data.begin() + scatter_offsets[i];
+  auto last = scatter_data.begin() + scatter_offsets[i + 1];
+  auto itr = std::lower_bound(first, last, std::make_pair(v->id, INT_MIN));
+  if (itr == last || itr->first != v->id) return nullptr;
+  hint = itr->second;
+  return path[hint + 1];
+}
@@ -4,59 +4,77 @@ SITable::SITable(CollisionTable *_CT) : CT(_CT) {}
 
 SITable::~SITable() {}
 
-SIs &SITable::get(Vertex *v)
+const SIs &SITable::get(Vertex *v)
 {
+  if (CT->flg_safe_intervals) return CT->getSafeIntervals(v->id);
+  auto itr = body.find(v->id);
+  if (itr != body.end()) return itr->second;
   auto &b_v = body[v->id];
-  if (!b_v.empty()) return b_v;
-  auto &entry = CT->body[v->id];
-  auto &entry_last = CT->body_last[v->id];
-  auto t_last = entry_last.empty()
-                    ? INT_MAX
-                    : *std::min_element(entry_last.begin(), entry_last.end());
-
-  // insert safe interval
-  auto time_start = 0;
-  for (auto t = 0; t < entry.size(); ++t) {
-    if (entry[t].empty()) continue;
-    auto time_end = t - 1;
-    if (time_start <= time_end) {
-      b_v.push_back(std::make_pair(time_start, time_end));
-    }
-    time_start = t + 1;
-    if (t_last == t) break;
-  }
-  // add last safe interval
-  if (t_last == INT_MAX) {
-    b_v.push_back(std::make_pair(time_start, INT_MAX - 1));
-  }
+  CT->computeSafeIntervals(v->id, b_v);
   return b_v;
 }
 
-SINode::SINode(const int _uuid, const SI &si, Vertex *_v, int _t, int _g,
-               int _f, SINode *_parent)
-    : uuid(_uuid),
-      time_start(si.first),
-      time_end(si.second),
-      v(_v),
-      t(_t),
-      g(_g),
-      f(_f),
-      parent(_parent)
+SIPPWorkspace::SIPPWorkspace()
+    : nodes(), OPEN(), explored(1024, {0, -1, -1, -1}), explored_size(0), gen(0)
+{
+}
+
+void SIPPWorkspace::clear()
+{
+  nodes.clear();
+  OPEN.clear();
+  explored_size = 0;
+  // invalidate all entries at once
+  if (++gen == 0) {
+    for (auto &&e : explored) e.gen = 0;
+    gen = 1;
+  }
+}
+
+int SIPPWorkspace::new_node(const SINode &n)
+{
+  nodes.push_back(n);
+  return nodes.size() - 1;
+}
+
+int SIPPWorkspace::find_slot(const int v_id, const int si_index) const
 {
+  const auto mask = explored.size() - 1;
+  uint hash = v_id;
+  hash ^= si_index + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  auto k = hash & mask;
+  while (explored[k].gen == gen &&
+         (explored[k].v_id != v_id || explored[k].si_index != si_index)) {
+    k = (k + 1) & mask;
+  }
+  return k;
 }
 
-bool SINode::operator==(const SINode &other) const
+int SIPPWorkspace::get_explored(const int v_id, const int si_index) const
 {
-  return (other.v->id == v->id && other.time_start == time_start &&
-          other.time_end == time_end);
+  auto &e = explored[find_slot(v_id, si_index)];
+  return (e.gen == gen) ? e.node : -1;
 }
 
-uint SINodeHasher::operator()(const SINode &n) const
+void SIPPWorkspace::set_explored(const int v_id, const int si_index,
+                                 const int node)
 {
-  uint hash = n.v->id;
-  hash ^= n.time_start + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-  hash ^= n.time_end + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-  return hash;
+  auto &e = explored[find_slot(v_id, si_index)];
+  if (e.gen == gen) {
+    e.node = node;
+    return;
+  }
+  e = {gen, v_id, si_index, node};
+  ++explored_size;
+  if (explored_size * 2 < (int)explored.size()) return;
+
+  // rehash, keeping entries of the current generation
+  auto old = std::vector<Entry>(explored.size() * 2, {0, -1, -1, -1});
+  std::swap(old, explored);
+  for (auto &&e_old : old) {
+    if (e_old.gen != gen) continue;
+    explored[find_slot(e_old.v_id, e_old.si_index)] = e_old;
+  }
 }
 
 // minimizing path-loss - not cost!
@@ -65,47 +83,50 @@ Path sipp(const int i, Vertex *s_i, Vertex *g_i, DistTable *D,
 {
   auto solution_path = Path();
   auto ST = SITable(CT);  // safe interval table
+  thread_local auto W = SIPPWorkspace();
+  W.clear();
+  auto &nodes = W.nodes;
 
   // setup goal
   auto &intervals_goal = ST.get(g_i);
   if (intervals_goal.empty()) return solution_path;
   const auto t_goal_after = intervals_goal.back().first - 1;
 
-  // setup OPEN lists
-  auto cmpNodes = [&](SINode *a, SINode *b) {
-    if (a->f != b->f) return a->f > b->f;
-    if (a->g != b->g) return a->g < b->g;
-    if (a->time_start != b->time_start) return a->time_start > b->time_start;
-    return a->uuid < b->uuid;
+  // setup OPEN lists, as a heap of node indexes
+  auto cmpNodes = [&](const int a, const int b) {
+    auto &n_a = nodes[a];
+    auto &n_b = nodes[b];
+    if (n_a.f != n_b.f) return n_a.f > n_b.f;
+    if (n_a.g != n_b.g) return n_a.g < n_b.g;
+    if (n_a.time_start != n_b.time_start)
+      return n_a.time_start > n_b.time_start;
+    return a < b;
   };
-
-  int node_id = 0;
-  auto OPEN =
-      std::priority_queue<SINode *, SINodes, decltype(cmpNodes)>(cmpNodes);
-  std::unordered_map<SINode, SINode *, SINodeHasher> EXPLORED;
-  OPEN.push(new SINode(++node_id, ST.get(s_i)[0], s_i, 0, 0, D->get(i, s_i),
-                       nullptr));
+  auto &OPEN = W.OPEN;
+  auto &si_start = ST.get(s_i)[0];
+  OPEN.push_back(W.new_node({si_start.first, si_start.second, 0, s_i, 0, 0,
+                             D->get(i, s_i), -1}));
 
   // main loop
   while (!OPEN.empty() && !is_expired(deadline)) {
-    auto n = OPEN.top();
-    OPEN.pop();
+    std::pop_heap(OPEN.begin(), OPEN.end(), cmpNodes);
+    const auto k = OPEN.back();
+    OPEN.pop_back();
+    const auto n = nodes[k];
 
     // check known node
-    auto itr_e = EXPLORED.find(*n);
-    if (itr_e != EXPLORED.end() && itr_e->second->g <= n->g) {
-      delete n;
-      continue;
-    }
-    EXPLORED[*n] = n;
+    const auto k_e = W.get_explored(n.v->id, n.si_index);
+    if (k_e != -1 && nodes[k_e].g <= n.g) continue;
+    W.set_explored(n.v->id, n.si_index, k);
 
     // goal check
-    if (n->v == g_i && n->t > t_goal_after) {
+    if (n.v == g_i && n.t > t_goal_after) {
       // backtrack
-      auto t = n->t;
+      auto m = &nodes[k];
+      auto t = n.t;
       while (t >= 0) {
-        solution_path.push_back(n->v);
-        if (t == n->t) n = n->parent;
+        solution_path.push_back(m->v);
+        if (t == m->t && m->parent != -1) m = &nodes[m->parent];
         --t;
       }
       std::reverse(solution_path.begin(), solution_path.end());
@@ -113,65 +134,50 @@ Path sipp(const int i, Vertex *s_i, Vertex *g_i, DistTable *D,
     }
 
     // expand neighbors
-    for (auto &u : n->v->neighbor) {
-      for (auto &si : ST.get(u)) {
+    for (auto &u : n.v->neighbor) {
+      auto &intervals = ST.get(u);
+      for (auto l = 0; l < (int)intervals.size(); ++l) {
+        auto &si = intervals[l];
         // invalid transition
-        if (si.first > n->time_end + 1) break;
-        if (si.second <= n->time_start) continue;
+        if (si.first > n.time_end + 1) break;
+        if (si.second <= n.time_start) continue;
 
         // check existence of t
+        const auto t_lo = std::max(n.t, si.first - 1);
+        const auto t_hi = std::min(n.time_end, si.second - 1);
         auto t_earliest = INT_MAX;
-        if (n->v != g_i) {
-          for (auto t = std::max(n->t, si.first - 1);
-               t <= std::min(n->time_end, si.second - 1); ++t) {
-            if (CT->getCollisionCost(n->v, u, t) == 0) {
-              t_earliest = t + 1;
-              break;
-            }
-          }
+        if (n.v != g_i) {
+          auto t = CT->getEarliestFreeMove(n.v->id, u->id, t_lo, t_hi);
+          if (t < INT_MAX) t_earliest = t + 1;
         } else {
           // for goal node -> reverse
-          for (auto t = std::min(n->time_end, si.second - 1);
-               t >= std::max(n->t, si.first - 1); --t) {
-            if (CT->getCollisionCost(n->v, u, t) == 0) {
-              t_earliest = t + 1;
-              break;
-            }
-          }
+          auto t = CT->getLatestFreeMove(n.v->id, u->id, t_lo, t_hi);
+          if (t >= 0) t_earliest = t + 1;
         }
         if (t_earliest >= INT_MAX) continue;
 
         // valid neighbor
-        auto g_val = n->g + (n->v != g_i ? t_earliest - n->t : 1);
+        auto g_val = n.g + (n.v != g_i ? t_earliest - n.t : 1);
         auto f_val = g_val + D->get(i, u);
-        auto n_new = new SINode(++node_id, si, u, t_earliest, g_val, f_val, n);
-
-        auto itr = EXPLORED.find(*n_new);
-        if (f_val > f_upper_bound ||
-            (itr != EXPLORED.end() && g_val >= itr->second->g)) {
-          delete n_new;
-        } else {
-          OPEN.push(n_new);
-        }
+        if (f_val > f_upper_bound) continue;
+        auto k_known = W.get_explored(u->id, l);
+        if (k_known != -1 && g_val >= nodes[k_known].g) continue;
+        OPEN.push_back(W.new_node(
+            {si.first, si.second, l, u, t_earliest, g_val, f_val, k}));
+        std::push_heap(OPEN.begin(), OPEN.end(), cmpNodes);
       }
     }
   }
 
-  // memory management
-  while (!OPEN.empty()) {
-    delete OPEN.top();
-    OPEN.pop();
-  }
-  for (auto iter : EXPLORED) delete iter.second;
   return solution_path;
 }
 
-std::ostream &operator<<(std::ostream &os, const SINode *n)
+std::ostream &operator<<(std::ostream &os, const SINode &n)
 {
-  os << "f=" << std::setw(4) << n->f << ", v=" << std::setw(6) << n->v
-     << ", t=" << std::setw(4) << n->t << ", si: [" << std::setw(4)
-     << n->time_start << ", " << std::setw(4)
-     << ((n->time_end < INT_MAX - 1) ? std::to_string(n->time_end) : "inf")
+  os << "f=" << std::setw(4) << n.f << ", v=" << std::setw(6) << n.v
+     << ", t=" << std::setw(4) << n.t << ", si: [" << std::setw(4)
+     << n.time_start << ", " << std::setw(4)
+     << ((n.time_end < INT_MAX - 1) ? std::to_string(n.time_end) : "inf")
      << "]";
   return os;
 }
@@ -0,0 +1,133 @@
+#include "../include/snapshot.hpp"
+
+Snapshot::Snapshot(const int _N)
+    : N(_N), T(0), offsets(N + 1, 0), vertex_ids(), nodes()
+{
+}
+
+SnapshotPtr Snapshot::from_configs(const Solution &solution)
+{
+  auto S = std::make_shared<Snapshot>(solution.front().size());
+  S->T = solution.size() - 1;
+  for (auto i = 0; i < S->N; ++i) {
+    // cut after reaching the goal
+    auto T_i = S->T;
+    while (T_i > 0 && solution[T_i - 1][i] == solution[S->T][i]) --T_i;
+    for (auto t = 0; t <= T_i; ++t) {
+      S->vertex_ids.push_back(solution[t][i]->id);
+    }
+    S->offsets[i + 1] = S->vertex_ids.size();
+  }
+  return S;
+}
+
+SnapshotPtr Snapshot::from_paths(const Paths &paths, const Snapshot *fallback)
+{
+  auto S = std::make_shared<Snapshot>(paths.size());
+  for (auto i = 0; i < S->N; ++i) {
+    if (paths[i].empty() && fallback != nullptr) {
+      auto &ids = fallback->vertex_ids;
+      S->vertex_ids.insert(S->vertex_ids.end(),
+                           ids.begin() + fallback->offsets[i],
+                           ids.begin() + fallback->offsets[i + 1]);
+    } else {
+      for (auto v : paths[i]) S->vertex_ids.push_back(v->id);
+    }
+    S->offsets[i + 1] = S->vertex_ids.size();
+    S->T = std::max(S->T, S->offsets[i + 1] - S->offsets[i] - 1);
+  }
+  return S;
+}
+
+Snapshot::Snapshot(const HNodes &_nodes)
+    : N(_nodes.front()->C.size()),
+      T(_nodes.size() - 1),
+      offsets(N + 1, 0),
+      vertex_ids(),
+      nodes(_nodes)
+{
+  for (auto i = 0; i < N; ++i) {
+    auto T_i = T;
+    while (T_i > 0 && nodes[T_i - 1]->C[i] == nodes[T]->C[i]) --T_i;
+    for (auto t = 0; t <= T_i; ++t) vertex_ids.push_back(nodes[t]->C[i]->id);
+    offsets[i + 1] = vertex_ids.size();
+  }
+}
+
+int Snapshot::get_vertex_id(const int i, const int t) const
+{
+  return vertex_ids[std::min(offsets[i] + t, offsets[i + 1] - 1)];
+}
+
+bool Snapshot::is_same_config(const int t, const Snapshot &other,
+                              const int t_other) const
+{
+  if (t > T || t_other > other.T) return false;
+  for (auto i = 0; i < N; ++i) {
+    if (get_vertex_id(i, t) != other.get_vertex_id(i, t_other)) return false;
+  }
+  return true;
+}
+
+void Snapshot::get_config(const int t, const Graph *G, Config &Q) const
+{
+  Q.resize(N);
+  for (auto i = 0; i < N; ++i) Q[i] = G->V[get_vertex_id(i, t)];
+}
+
+int Snapshot::get_sum_of_loss(const int t_from) const
+{
+  auto c = 0;
+  for (auto i = 0; i < N; ++i) {
+    const auto g = vertex_ids[offsets[i + 1] - 1];
+    for (auto k = offsets[i] + t_from + 1; k < offsets[i + 1]; ++k) {
+      if (vertex_ids[k - 1] != g || vertex_ids[k] != g) ++c;
+    }
+  }
+  return c;
+}
+
+int Snapshot::get_path_loss(const int i) const
+{
+  auto c = 0;
+  const auto g = vertex_ids[offsets[i + 1] - 1];
+  for (auto k = offsets[i] + 1; k < offsets[i + 1]; ++k) {
+    if (vertex_ids[k - 1] != g || vertex_ids[k] != g) ++c;
+  }
+  return c;
+}
+
+void Snapshot::get_path(const int i, const Graph *G, Path &path) const
+{
+  path.clear();
+  for (auto k = offsets[i]; k < offsets[i + 1]; ++k) {
+    path.push_back(G->V[vertex_ids[k]]);
+  }
+}
+
+Paths Snapshot::get_paths(const Graph *G) const
+{
+  auto paths = Paths(N);
+  for (auto i = 0; i < N; ++i) get_path(i, G, paths[i]);
+  return paths;
+}
+
+Solution Snapshot::get_solution(const Graph *G) const
+{
+  auto solution = Solution(T + 1);
+  for (auto t = 0; t <= T; ++t) get_config(t, G, solution[t]);
+  return solution;
+}
+
+const CollisionTable *Snapshot::get_collision_table(const Instance *ins) const
+{
+  std::call_once(flg_collision_table, [&]() {
+    collision_table = std::make_unique<CollisionTable>(ins);
+    auto path = Path();
+    for (auto i = 0; i < N; ++i) {
+      get_path(i, ins->G, path);
+      collision_table->enrollPath(i, path);
+    }
+  });
+  return collision_table.get();
+}
@@ -2,8 +2,16 @@
 
 void info(const int level, const int verbose) { std::cout << std::endl; }
 
-Deadline::Deadline(double _time_limit_ms)
-    : t_s(Time::now()), time_limit_ms(_time_limit_ms)
+Deadline::Deadline(double _time_limit_ms,
+                   const std::atomic<bool> *_flg_cancel)
+    : t_s(Time::now()), time_limit_ms(_time_limit_ms), flg_cancel(_flg_cancel)
+{
+}
+
+Deadline::Deadline(const Deadline *parent, const std::atomic<bool> *_flg_cancel)
+    : t_s(parent == nullptr ? Time::now() : parent->t_s),
+      time_limit_ms(parent == nullptr ? INT_MAX : parent->time_limit_ms),
+      flg_cancel(_flg_cancel)
 {
 }
 
@@ -35,6 +43,7 @@ double elapsed_ns(const Deadline *deadline)
 bool is_expired(const Deadline *deadline)
 {
   if (deadline == nullptr) return false;
+  if (deadline->flg_cancel != nullptr && *deadline->flg_cancel) return true;
   return deadline->elapsed_ms() > deadline->time_limit_ms;
 }
 
@@ -64,6 +64,9 @@ int main(int argc, char *argv[])
   program.add_argument("--scatter-margin")
       .help("allowing non-shortest paths in SUO")
       .default_value(std::string("10"));
+  program.add_argument("--scatter-threads")
+      .help("number of threads in SUO, >1 -> replan agent batches in parallel")
+      .default_value(std::string("1"));
   program.add_argument("--no-refiner")
       .help("turn off iterative refinement")
       .default_value(false)
@@ -71,6 +74,17 @@ int main(int argc, char *argv[])
   program.add_argument("--refiner-num")
       .help("specify the number of refiners")
       .default_value(std::string("4"));
+  program.add_argument("--refiner-neighbor")
+      .help(
+          "neighborhood of refiners: random, delay, intersection, region, or "
+          "adaptive")
+      .default_value(std::string("random"));
+  program.add_argument("--refiner-scheduler")
+      .help(
+          "choose recursive LaCAM or iterative refinement, and its "
+          "neighborhood size, by their observed gain per ms")
+      .default_value(false)
+      .implicit_value(true);
   program.add_argument("--recursive-rate")
       .help("specify the rate of the recursive call of LaCAM")
       .default_value(std::string("0.2"));
@@ -112,9 +126,26 @@ int main(int argc, char *argv[])
       flg_no_all ? 1 : std::stoi(program.get<std::string>("pibt-num"));
   Planner::FLG_REFINER = !program.get<bool>("no-refiner") && !flg_no_all;
   Planner::REFINER_NUM = std::stoi(program.get<std::string>("refiner-num"));
+  const auto refiner_neighbor = program.get<std::string>("refiner-neighbor");
+  Planner::REFINER_NEIGHBOR = NB_ADAPTIVE;
+  for (auto nb = 0; nb < NB_NUM; ++nb) {
+    if (refiner_neighbor == REFINER_NEIGHBOR_NAMES[nb]) {
+      Planner::REFINER_NEIGHBOR = nb;
+    }
+  }
+  if (Planner::REFINER_NEIGHBOR == NB_ADAPTIVE &&
+      refiner_neighbor != "adaptive") {
+    std::cerr << "unknown refiner neighborhood: " << refiner_neighbor
+              << std::endl;
+    return 1;
+  }
+  Planner::FLG_REFINER_SCHEDULER =
+      program.get<bool>("refiner-scheduler") && !flg_no_all;
   Planner::FLG_SCATTER = !program.get<bool>("no-scatter") && !flg_no_all;
   Planner::SCATTER_MARGIN =
       std::stoi(program.get<std::string>("scatter-margin"));
+  Planner::SCATTER_THREADS =
+      std::stoi(program.get<std::string>("scatter-threads"));
   Planner::RANDOM_INSERT_PROB1 =
       flg_no_all ? 0
                  : std::stof(program.get<std::string>("random-insert-prob1"));
@@ -0,0 +1,663 @@
+#include "mvc_kernel.h"
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+void add_edge_to_key(MvcKey& key, const std::pair<int, int>& e) {
+    const uint64_t x = (uint64_t)std::min(e.first, e.second) << 32 |
+                       (uint32_t)std::max(e.first, e.second);
+    key.h1 += mix(x);
+    key.h2 ^= mix(x ^ 0x9e3779b97f4a7c15ULL);
+    key.num_edges++;
+}
+
+}  // namespace
+
+int MvcKernel::add_vertex() {
+    int v = n++;
+    if ((int)adj.size() < n) {
+        adj.resize(n);
+        deg.resize(n);
+        alive.resize(n);
+        mark.resize(n);
+        mate.resize(n);
+        visited.resize(n);
+    }
+    adj[v].clear();
+    deg[v] = 0;
+    alive[v] = 1;
+    mark[v] = 0;
+    verts.push_back(v);
+    return v;
+}
+
+void MvcKernel::remove_vertex(int v) {
+    alive[v] = 0;
+    for (int u : adj[v]) {
+        if (!alive[u])
+            continue;
+        if (--deg[u] <= 2)
+            low.push_back(u);
+    }
+}
+
+void MvcKernel::take(int v) {
+    offset++;
+    remove_vertex(v);
+}
+
+bool MvcKernel::is_adjacent(int u, int w) {
+    if (adj[u].size() > adj[w].size())
+        std::swap(u, w);
+    for (int y : adj[u]) {
+        if (y == w)
+            return true;
+    }
+    return false;
+}
+
+// v of degree two with non-adjacent neighbors u and w is merged with them,
+// the cover size of the folded graph is smaller by one
+void MvcKernel::fold(int v, int u, int w) {
+    int z = add_vertex();
+    alive[v] = alive[u] = alive[w] = 0;
+    for (int x : {u, w}) {
+        for (int y : adj[x]) {
+            if (!alive[y] || y == z)
+                continue;
+            if (mark[y] == 0) {
+                mark[y] = 1;
+                adj[z].push_back(y);
+            } else {
+                mark[y] = 2;  // adjacent to both u and w
+            }
+        }
+    }
+    for (int y : adj[z]) {
+        adj[y].push_back(z);
+        if (mark[y] == 2)
+            deg[y]--;
+        mark[y] = 0;
+        if (deg[y] <= 2)
+            low.push_back(y);
+    }
+    deg[z] = adj[z].size();
+    if (deg[z] <= 2)
+        low.push_back(z);
+    offset++;
+}
+
+void MvcKernel::reduce_degree() {
+    int nb[2];
+    while (!low.empty()) {
+        int v = low.back();
+        low.pop_back();
+        if (!alive[v] || deg[v] > 2)
+            continue;
+        int k = 0;
+        for (int u : adj[v]) {
+            if (alive[u] && k < 2)
+                nb[k++] = u;
+        }
+        if (deg[v] == 0) {
+            alive[v] = 0;
+        } else if (deg[v] == 1) {
+            take(nb[0]);
+            alive[v] = 0;
+        } else if (is_adjacent(nb[0], nb[1])) {
+            take(nb[0]);
+            take(nb[1]);
+            alive[v] = 0;
+        } else {
+            fold(v, nb[0], nb[1]);
+        }
+    }
+}
+
+bool MvcKernel::augment(int o, int gen) {
+    for (int h : adj[o]) {
+        if (!alive[h] || visited[h] == gen)
+            continue;
+        visited[h] = gen;
+        if (mate[h] == -1 || augment(mate[h], gen)) {
+            mate[h] = o;
+            mate[o] = h;
+            return true;
+        }
+    }
+    return false;
+}
+
+// crown (I, H): I is independent, H = N(I) is matched into I, then H can be
+// taken into the cover, following Chor, Fellows and Juedes
+bool MvcKernel::reduce_crown() {
+    // vertices outside a maximal matching form an independent set
+    auto& O = crown_o;
+    O.clear();
+    for (int v : verts) {
+        if (!alive[v] || mark[v] == 1)
+            continue;
+        for (int u : adj[v]) {
+            if (alive[u] && mark[u] == 0) {
+                mark[v] = mark[u] = 1;
+                break;
+            }
+        }
+    }
+    for (int v : verts) {
+        if (alive[v] && mark[v] == 0)
+            O.push_back(v);
+        mark[v] = 0;
+        mate[v] = -1;
+        visited[v] = 0;
+    }
+    if (O.empty())
+        return false;
+
+    // maximum matching between O and N(O)
+    int gen = 0;
+    for (int o : O)
+        augment(o, ++gen);
+
+    // unmatched vertices of O, extended by alternating paths
+    auto& I = crown_i;
+    auto& H = crown_h;
+    I.clear();
+    H.clear();
+    for (int o : O) {
+        if (mate[o] == -1) {
+            mark[o] = 2;
+            I.push_back(o);
+        }
+    }
+    if (I.empty())
+        return false;
+    for (size_t k = 0; k < I.size(); ++k) {
+        for (int h : adj[I[k]]) {
+            if (!alive[h] || mark[h] == 3)
+                continue;
+            mark[h] = 3;
+            H.push_back(h);
+            int o = mate[h];
+            if (o != -1 && mark[o] != 2) {
+                mark[o] = 2;
+                I.push_back(o);
+            }
+        }
+    }
+    for (int h : H)
+        take(h);
+    for (int o : I)
+        alive[o] = 0;
+    for (int v : verts)
+        mark[v] = 0;
+    return true;
+}
+
+void MvcKernel::branch(uint64_t rem, int size) {
+    while (true) {
+        if (size >= best)
+            return;
+        if (rem == 0) {
+            best = size;
+            return;
+        }
+
+        // degree-0/1 rules
+        bool changed = false;
+        int v_max = -1;
+        int d_max = -1;
+        for (uint64_t r = rem; r != 0; r &= r - 1) {
+            int v = __builtin_ctzll(r);
+            uint64_t nb = kernel_adj[v] & rem;
+            int d = __builtin_popcountll(nb);
+            if (d <= 1) {
+                if (d == 1) {
+                    rem &= ~(uint64_t(1) << __builtin_ctzll(nb));
+                    size++;
+                }
+                rem &= ~(uint64_t(1) << v);
+                changed = true;
+                break;
+            }
+            if (d > d_max) {
+                d_max = d;
+                v_max = v;
+            }
+        }
+        if (changed)
+            continue;
+
+        // paths and cycles, solved in closed form
+        if (d_max <= 2) {
+            for (uint64_t r = rem; r != 0;) {
+                uint64_t comp = r & (~r + 1);
+                uint64_t frontier = comp;
+                while (frontier != 0) {
+                    uint64_t next = 0;
+                    for (uint64_t f = frontier; f != 0; f &= f - 1)
+                        next |= kernel_adj[__builtin_ctzll(f)];
+                    frontier = next & rem & ~comp;
+                    comp |= frontier;
+                }
+                int nv = __builtin_popcountll(comp);
+                int ne = 0;
+                for (uint64_t c = comp; c != 0; c &= c - 1)
+                    ne += __builtin_popcountll(kernel_adj[__builtin_ctzll(c)] & comp);
+                size += (ne / 2 == nv) ? (nv + 1) / 2 : nv / 2;
+                r &= ~comp;
+            }
+            best = std::min(best, size);
+            return;
+        }
+
+        // lower bound by a greedy matching
+        int lb = 0;
+        for (uint64_t r = rem; r != 0;) {
+            int v = __builtin_ctzll(r);
+            r &= ~(uint64_t(1) << v);
+            uint64_t nb = kernel_adj[v] & r;
+            if (nb != 0) {
+                r &= ~(nb & (~nb + 1));
+                lb++;
+            }
+        }
+        if (size + lb >= best || ++nodes > MVC_EXACT_MAX_NODES)
+            return;
+
+        // v_max in the cover, or all of its neighbors
+        uint64_t rem_v = rem & ~(uint64_t(1) << v_max);
+        branch(rem_v, size + 1);
+        rem = rem_v & ~kernel_adj[v_max];
+        size += d_max;
+    }
+}
+
+int MvcKernel::find(int i) {
+    while (uf[i] != i) {
+        uf[i] = uf[uf[i]];
+        i = uf[i];
+    }
+    return i;
+}
+
+// exact cover size of the component kernel[i_begin, i_end)
+int MvcKernel::solve_exact(int i_begin, int i_end) {
+    int k = i_end - i_begin;
+    if (k == 2)
+        return 1;  // single edge
+    for (int i = i_begin; i < i_end; ++i)
+        mate[kernel[i]] = i - i_begin;
+    kernel_adj.assign(k, 0);
+    for (int i = i_begin; i < i_end; ++i) {
+        for (int u : adj[kernel[i]]) {
+            if (alive[u])
+                kernel_adj[i - i_begin] |= uint64_t(1) << mate[u];
+        }
+    }
+    best = k;
+    nodes = 0;
+    branch((k == 64) ? ~uint64_t(0) : (uint64_t(1) << k) - 1, 0);
+    return best;
+}
+
+int MvcKernel::solve_component(
+    const std::vector<std::pair<int, int>>& edges, int vertex_count,
+    double cutoff_time, std::vector<int>* cover) {
+    for (int v : verts)
+        alive[v] = 0;
+    verts.clear();
+    low.clear();
+    offset = 0;
+    n = vertex_count;
+    if ((int)adj.size() < n) {
+        adj.resize(n);
+        deg.resize(n);
+        alive.resize(n);
+        mark.resize(n);
+        mate.resize(n);
+        visited.resize(n);
+    }
+
+    // build adjacency of the vertices with edges
+    loops.clear();
+    for (auto& e : edges) {
+        for (int v : {e.first, e.second}) {
+            if (alive[v])
+                continue;
+            alive[v] = 1;
+            mark[v] = 0;
+            adj[v].clear();
+            verts.push_back(v);
+        }
+        if (e.first == e.second) {
+            loops.push_back(e.first);
+            continue;
+        }
+        adj[e.first].push_back(e.second);
+        adj[e.second].push_back(e.first);
+    }
+    for (int v : verts) {
+        std::sort(adj[v].begin(), adj[v].end());
+        adj[v].erase(std::unique(adj[v].begin(), adj[v].end()), adj[v].end());
+        deg[v] = adj[v].size();
+    }
+    for (int v : loops) {
+        if (alive[v])
+            take(v);
+    }
+    for (int v : verts) {
+        if (alive[v] && deg[v] <= 2)
+            low.push_back(v);
+    }
+
+    // reductions
+    reduce_degree();
+    while (reduce_crown())
+        reduce_degree();
+
+    kernel.clear();
+    for (int v : verts) {
+        if (alive[v])
+            kernel.push_back(v);
+    }
+    if (kernel.empty())
+        return offset;
+
+    // connected components by union-find, the cover size is additive
+    uf.resize(kernel.size());
+    for (size_t i = 0; i < kernel.size(); ++i) {
+        mate[kernel[i]] = i;
+        uf[i] = i;
+    }
+    for (size_t i = 0; i < kernel.size(); ++i) {
+        for (int u : adj[kernel[i]]) {
+            if (!alive[u])
+                continue;
+            int r1 = find(i);
+            int r2 = find(mate[u]);
+            if (r1 != r2)
+                uf[r1] = r2;
+        }
+    }
+    // group by component, uf[i] becomes the component of kernel[i]
+    comps.resize(kernel.size());
+    for (size_t i = 0; i < kernel.size(); ++i)
+        comps[i] = {find(i), kernel[i]};
+    std::sort(comps.begin(), comps.end());
+    for (size_t i = 0; i < kernel.size(); ++i)
+        std::tie(uf[i], kernel[i]) = comps[i];
+
+    auto size = offset;
+    large_edges.clear();
+    for (size_t i = 0, j = 0; i < kernel.size(); i = j) {
+        while (j < kernel.size() && uf[j] == uf[i])
+            ++j;
+        if (j - i <= MVC_EXACT_MAX_VERTICES) {
+            size += solve_exact(i, j);
+            continue;
+        }
+        large_edges.emplace_back();
+        for (size_t k = i; k < j; ++k) {
+            for (int u : adj[kernel[k]]) {
+                if (alive[u] && kernel[k] < u)
+                    large_edges.back().push_back({kernel[k], u});
+            }
+        }
+    }
+    if (large_edges.empty())
+        return size;
+
+    // large components by numvc, concurrently when worth it, each seeded by
+    // the agents of the seed in it, the cover is repaired by numvc
+    large_inits.resize(large_edges.size());
+    auto num_edges = 0;
+    for (size_t k = 0; k < large_edges.size(); ++k) {
+        num_edges += large_edges[k].size();
+        large_inits[k].clear();
+        if (in_seed.empty())
+            continue;
+        for (auto& e : large_edges[k]) {
+            for (int v : {e.first, e.second}) {
+                // folded vertices are not agents
+                if (v < vertex_count && in_seed[v] == 1) {
+                    in_seed[v] = 2;
+                    large_inits[k].push_back(v);
+                }
+            }
+        }
+        for (int v : large_inits[k])
+            in_seed[v] = 1;
+    }
+    auto solve_large = [&](size_t k) {
+        return numvc_solve_mvc(
+            large_edges[k], n, 0, cutoff_time, 1,
+            large_inits[k].empty() ? nullptr : &large_inits[k],
+            numvc_step_budget(large_edges[k].size()));
+    };
+    large_results.resize(large_edges.size());
+    if (large_edges.size() == 1 || num_edges < MVC_PARALLEL_MIN_EDGES) {
+        for (size_t k = 0; k < large_edges.size(); ++k)
+            large_results[k] = solve_large(k);
+    } else {
+        std::vector<std::future<MVCResult>> results;
+        for (size_t k = 1; k < large_edges.size(); ++k)
+            results.push_back(std::async(std::launch::async, solve_large, k));
+        large_results[0] = solve_large(0);
+        for (size_t k = 1; k < large_edges.size(); ++k)
+            large_results[k] = results[k - 1].get();
+    }
+    for (size_t k = 0; k < large_edges.size(); ++k) {
+        size += large_results[k].mvc_size;
+        if (cover == nullptr || !large_results[k].success)
+            continue;
+        for (int v : large_results[k].mvc) {
+            if (v < vertex_count)
+                cover->push_back(v);
+        }
+    }
+    return size;
+}
+
+int MvcKernel::solve(const std::vector<std::pair<int, int>>& edges,
+                     int vertex_count, double cutoff_time,
+                     const std::vector<int>* seed, std::vector<int>* cover) {
+    // connected components of the input by union-find
+    if ((int)raw_uf.size() < vertex_count) {
+        raw_uf.resize(vertex_count, -1);
+        raw_comp.resize(vertex_count, -1);
+    }
+    auto find_raw = [&](int v) {
+        while (raw_uf[v] != v) {
+            raw_uf[v] = raw_uf[raw_uf[v]];
+            v = raw_uf[v];
+        }
+        return v;
+    };
+    for (auto& e : edges) {
+        for (int v : {e.first, e.second}) {
+            if (raw_uf[v] == -1) {
+                raw_uf[v] = v;
+                raw_verts.push_back(v);
+            }
+        }
+        int r1 = find_raw(e.first);
+        int r2 = find_raw(e.second);
+        if (r1 != r2)
+            raw_uf[r1] = r2;
+    }
+
+    // order-independent keys of edge sets, with agent ids
+    comp_keys.clear();
+    for (auto& e : edges) {
+        int r = find_raw(e.first);
+        if (raw_comp[r] == -1) {
+            raw_comp[r] = comp_keys.size();
+            comp_keys.push_back({0, 0, 0});
+        }
+        add_edge_to_key(comp_keys[raw_comp[r]], e);
+    }
+
+    if (seed != nullptr && !seed->empty()) {
+        in_seed.assign(vertex_count, 0);
+        for (int v : *seed) {
+            if (v >= 0 && v < vertex_count)
+                in_seed[v] = 1;
+        }
+    }
+
+    // look up the cache, small components are solved directly
+    auto size = 0;
+    comp_sizes.assign(comp_keys.size(), -1);
+    auto num_solved = 0;
+    for (size_t c = 0; c < comp_keys.size(); ++c) {
+        if (comp_keys[c].num_edges >= MVC_CACHE_MIN_EDGES &&
+            mvc_cache_get(comp_keys[c], comp_sizes[c])) {
+            size += comp_sizes[c];
+        } else {
+            ++num_solved;
+        }
+    }
+    // the seed stays a cover hint of components answered by the cache
+    if (cover != nullptr && !in_seed.empty()) {
+        for (int v : raw_verts) {
+            if (in_seed[v] && comp_sizes[raw_comp[find_raw(v)]] != -1)
+                cover->push_back(v);
+        }
+    }
+    if (num_solved > 0) {
+        if (comp_edges.size() < comp_keys.size())
+            comp_edges.resize(comp_keys.size());
+        for (size_t c = 0; c < comp_keys.size(); ++c)
+            comp_edges[c].clear();
+        for (auto& e : edges) {
+            int c = raw_comp[find_raw(e.first)];
+            if (comp_sizes[c] == -1)
+                comp_edges[c].push_back(e);
+        }
+        for (size_t c = 0; c < comp_keys.size(); ++c) {
+            if (comp_sizes[c] != -1)
+                continue;
+            comp_sizes[c] = solve_component(comp_edges[c], vertex_count,
+                                            cutoff_time, cover);
+            if (comp_keys[c].num_edges >= MVC_CACHE_MIN_EDGES)
+                mvc_cache_put(comp_keys[c], comp_sizes[c]);
+            size += comp_sizes[c];
+        }
+    }
+
+    for (int v : raw_verts)
+        raw_uf[v] = raw_comp[v] = -1;
+    raw_verts.clear();
+    in_seed.clear();
+    return size;
+}
+
+namespace {
+
+// two generations per shard, the older one is dropped when the newer is full
+struct MvcCacheShard {
+    struct Entry {
+        uint64_t h2;
+        int num_edges;
+        int size;
+    };
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> current;
+    std::unordered_map<uint64_t, Entry> previous;
+};
+
+MvcCacheShard mvc_cache_shards[MVC_CACHE_SHARDS];
+std::atomic<long long> mvc_cache_hits(0);
+std::atomic<long long> mvc_cache_misses(0);
+
+}  // namespace
+
+bool mvc_cache_get(const MvcKey& key, int& size) {
+    auto& shard = mvc_cache_shards[key.h1 % MVC_CACHE_SHARDS];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto itr = shard.current.find(key.h1);
+        if (itr == shard.current.end()) {
+            itr = shard.previous.find(key.h1);
+            if (itr != shard.previous.end() && itr->second.h2 == key.h2 &&
+                itr->second.num_edges == key.num_edges) {
+                // keep the recently used one
+                shard.current[key.h1] = itr->second;
+                size = itr->second.size;
+                ++mvc_cache_hits;
+                return true;
+            }
+        } else if (itr->second.h2 == key.h2 &&
+                   itr->second.num_edges == key.num_edges) {
+            size = itr->second.size;
+            ++mvc_cache_hits;
+            return true;
+        }
+    }
+    ++mvc_cache_misses;
+    return false;
+}
+
+void mvc_cache_put(const MvcKey& key, int size) {
+    auto& shard = mvc_cache_shards[key.h1 % MVC_CACHE_SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.current.size() >= MVC_CACHE_CAPACITY / MVC_CACHE_SHARDS) {
+        shard.previous = std::move(shard.current);
+        shard.current.clear();
+    }
+    shard.current[key.h1] = {key.h2, key.num_edges, size};
+}
+
+void mvc_cache_clear() {
+    for (auto& shard : mvc_cache_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.current.clear();
+        shard.previous.clear();
+    }
+    mvc_cache_hits = 0;
+    mvc_cache_misses = 0;
+}
+
+long long mvc_cache_get_hits() {
+    return mvc_cache_hits;
+}
+
+long long mvc_cache_get_misses() {
+    return mvc_cache_misses;
+}
+
+namespace {
+
+thread_local const std::vector<int>* bound_seed = nullptr;
+thread_local std::vector<int>* bound_cover = nullptr;
+
+}  // namespace
+
+void mvc_bind_cover(const std::vector<int>* seed, std::vector<int>* cover) {
+    bound_seed = seed;
+    bound_cover = cover;
+    if (cover != nullptr)
+        cover->clear();
+}
+
+int mvc_solve(const std::vector<std::pair<int, int>>& edges, int vertex_count,
+              double cutoff_time) {
+    static thread_local MvcKernel kernel;
+    if (edges.empty() || vertex_count <= 0)
+        return 0;
+    return kernel.solve(edges, vertex_count, cutoff_time, bound_seed,
+                        bound_cover);
+}
+
+int numvc(const std::vector<std::pair<int, int>>& edges, int vertex_count) {
+    return mvc_solve(edges, vertex_count);
+}
@@ -0,0 +1,112 @@
+#ifndef MVC_KERNEL_H
+#define MVC_KERNEL_H
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+#include "numvc.h"
+
+// kernels up to this size are solved exactly by branch and bound
+constexpr int MVC_EXACT_MAX_VERTICES = 64;
+// branch and bound keeps the best cover found when exceeding this
+constexpr long long MVC_EXACT_MAX_NODES = 100000;
+// large components are solved in parallel above this number of edges
+constexpr int MVC_PARALLEL_MIN_EDGES = 1000;
+// number of cover sizes kept by the cache, over all shards
+constexpr size_t MVC_CACHE_CAPACITY = 1 << 16;
+constexpr int MVC_CACHE_SHARDS = 16;
+// smaller components are solved by reductions faster than a lookup
+constexpr int MVC_CACHE_MIN_EDGES = 8;
+
+// order-independent 128-bit hash of an edge set, with agent ids
+struct MvcKey {
+    uint64_t h1;
+    uint64_t h2;
+    int num_edges;
+};
+
+// vertex cover reductions, degree-0/1, degree-2 folding and crown, then
+// each connected component of the kernel is solved separately, exactly when
+// small and by numvc otherwise; trees vanish by the degree-1 rule
+class MvcKernel {
+public:
+    // size of a minimum vertex cover, or the best found by numvc,
+    // connected components of the input go through the cache;
+    // seed (agent ids) is a cover of a similar graph, e.g., of the parent
+    // configuration, its vertices in a component seed numvc there;
+    // the agents put in the cover by numvc, or kept from the seed in
+    // components answered by the cache, are appended to cover
+    int solve(const std::vector<std::pair<int, int>>& edges, int vertex_count,
+              double cutoff_time, const std::vector<int>* seed = nullptr,
+              std::vector<int>* cover = nullptr);
+
+private:
+    // components of the input
+    std::vector<int> raw_uf;      // -1 -> unused
+    std::vector<int> raw_comp;    // root -> component index
+    std::vector<int> raw_verts;
+    std::vector<MvcKey> comp_keys;
+    std::vector<int> comp_sizes;  // -1 -> to be solved
+    std::vector<std::vector<std::pair<int, int>>> comp_edges;
+    std::vector<char> in_seed;    // agent id -> in the seed
+
+
+    int n;                        // number of vertices, with folded ones
+    int offset;                   // vertices put in the cover by reductions
+    std::vector<int> verts;       // vertices used in this call
+    std::vector<std::vector<int>> adj;  // lazy, may contain removed ones
+    std::vector<int> deg;         // number of alive neighbors
+    std::vector<char> alive;
+    std::vector<int> low;         // candidates of degree <= 2
+    std::vector<int> mark;        // scratch, cleared after use
+    std::vector<int> mate;        // scratch of crown reduction
+    std::vector<int> visited;
+    std::vector<int> crown_o;
+    std::vector<int> crown_i;
+    std::vector<int> crown_h;
+    std::vector<int> loops;
+    std::vector<int> kernel;      // remaining vertices, grouped by component
+    std::vector<int> uf;          // union-find over kernel indexes
+    std::vector<std::pair<int, int>> comps;  // (component, vertex)
+    std::vector<uint64_t> kernel_adj;
+    std::vector<std::vector<std::pair<int, int>>> large_edges;
+    std::vector<std::vector<int>> large_inits;  // from the seed
+    std::vector<MVCResult> large_results;
+    int best;
+    long long nodes;
+
+    int add_vertex();
+    void remove_vertex(int v);
+    void take(int v);
+    bool is_adjacent(int u, int w);
+    void fold(int v, int u, int w);
+    void reduce_degree();
+    bool reduce_crown();
+    bool augment(int o, int gen);
+    int find(int i);
+    int solve_exact(int i_begin, int i_end);
+    void branch(uint64_t rem, int size);
+    int solve_component(const std::vector<std::pair<int, int>>& edges,
+                        int vertex_count, double cutoff_time,
+                        std::vector<int>* cover);
+};
+
+// thread-safe bounded cache, edge set of a connected component -> cover size
+bool mvc_cache_get(const MvcKey& key, int& size);
+void mvc_cache_put(const MvcKey& key, int size);
+void mvc_cache_clear();
+long long mvc_cache_get_hits();
+long long mvc_cache_get_misses();
+
+// numvc runs with a step budget, cutoff_time is its coarse guard
+int mvc_solve(const std::vector<std::pair<int, int>>& edges, int vertex_count,
+              double cutoff_time = NUMVC_CLOCK_GUARD);
+
+// bind a seed cover and an output cover (agent ids) to mvc_solve on the
+// calling thread, see MvcKernel::solve; cover is cleared here
+// nullptr -> none
+void mvc_bind_cover(const std::vector<int>* seed, std::vector<int>* cover);
+
+#endif
@@ -2,79 +2,23 @@
 
 static int try_step = 100;
 
-// Heap functions
-void NumvcSolver::my_heap_swap(int a, int b) {
-    int t = my_heap[a];
-    my_heap[a] = my_heap[b];
-    pos_in_my_heap[my_heap[a]] = a;
-    my_heap[b] = t;
-    pos_in_my_heap[my_heap[b]] = b;
+// Bucket queue functions
+void NumvcSolver::bucket_insert(int v) {
+    int d = dscore[v];
+    bucket_prev[v] = 0;
+    bucket_next[v] = bucket_head[d];
+    if (bucket_head[d] != 0)
+        bucket_prev[bucket_head[d]] = v;
+    bucket_head[d] = v;
 }
 
-bool NumvcSolver::my_heap_is_leaf(int pos) {
-    return (pos >= my_heap_count / 2) && (pos < my_heap_count);
-}
-
-// These are static helpers, not part of the class state
-int my_heap_left_child(int pos) {
-    return (2 * pos + 1);
-}
-
-int my_heap_right_child(int pos) {
-    return (2 * pos + 2);
-}
-
-int my_heap_parent(int pos) {
-    return (pos - 1) / 2;
-}
-
-void NumvcSolver::my_heap_shiftdown(int pos) {
-    while (!my_heap_is_leaf(pos)) {
-        int j = my_heap_left_child(pos);
-        int rc = my_heap_right_child(pos);
-        if ((rc < my_heap_count) &&
-            (dscore[my_heap[rc]] > dscore[my_heap[j]]))
-            j = rc;
-        if (dscore[my_heap[pos]] > dscore[my_heap[j]])
-            return;
-        my_heap_swap(pos, j);
-        pos = j;
-    }
-}
-
-void NumvcSolver::my_heap_insert(int v) {
-    int curr = my_heap_count++;
-    my_heap[curr] = v;
-    pos_in_my_heap[v] = curr;
-
-    while (curr != 0 && dscore[my_heap[curr]] >
-           dscore[my_heap[my_heap_parent(curr)]]) {
-        my_heap_swap(curr, my_heap_parent(curr));
-        curr = my_heap_parent(curr);
-    }
-}
-
-int NumvcSolver::my_heap_remove_first() {
-    my_heap_swap(0, --my_heap_count);
-    if (my_heap_count != 0)
-        my_heap_shiftdown(0);
-    return my_heap[my_heap_count];
-}
-
-int NumvcSolver::my_heap_remove(int pos) {
-    if (pos == (my_heap_count - 1))
-        my_heap_count--;
-    else {
-        my_heap_swap(pos, --my_heap_count);
-        while ((pos != 0) && (dscore[my_heap[pos]] >
-               dscore[my_heap[my_heap_parent(pos)]])) {
-            my_heap_swap(pos, my_heap_parent(pos));
-            pos = my_heap_parent(pos);
-        }
-        if (my_heap_count != 0)
-            my_heap_shiftdown(pos);
-    }
-    return my_heap[my_heap_count];
+void NumvcSolver::bucket_remove(int v) {
+    if (bucket_prev[v] != 0)
+        bucket_next[bucket_prev[v]] = bucket_next[v];
+    else
+        bucket_head[dscore[v]] = bucket_next[v];
+    if (bucket_next[v] != 0)
+        bucket_prev[bucket_next[v]] = bucket_prev[v];
 }
 
 // Core MVC functions
@@ -89,28 +33,42 @@ void NumvcSolver::update_best_sol() {
     best_step = step;
 }
 
-// Private helper function: allocate memory
+// Private helper function: reset the search state for a new instance
+void NumvcSolver::reset_state() {
+    step = 0;
+    tabu_remove = 0;
+    ave_weight = 1;
+    delta_total_weight = 0;
+    uncov_stack_fill_pointer = 0;
+}
+
+// Private helper function: grow buffers if needed and reset the used prefix
 void NumvcSolver::allocate_memory() {
-    edge = new Edge[e_num];
-    edge_weight = new int[e_num];
-    uncov_stack = new int[e_num];
-    index_in_uncov_stack = new int[e_num];
+    if ((int)edge.size() < e_num) {
+        edge.resize(e_num);
+        edge_weight.resize(e_num);
+        uncov_stack.resize(e_num);
+        index_in_uncov_stack.resize(e_num);
+        v_edges.resize(2 * e_num);
+        v_adj.resize(2 * e_num);
+    }
     for (int i = 0; i < e_num; i++) {
         index_in_uncov_stack[i] = -1;
     }
-    dscore = new int[v_num + 1];
-    time_stamp = new long long[v_num + 1];
-    v_edges = new int*[v_num + 1];
-    v_adj = new int*[v_num + 1];
-    v_edge_count = new int[v_num + 1];
-    v_in_c = new int[v_num + 1];
-    remove_cand = new int[v_num + 1];
-    index_in_remove_cand = new int[v_num + 1];
-    best_v_in_c = new int[v_num + 1];
-    conf_change = new int[v_num + 1];
-    my_heap = new int[v_num + 1];
-    pos_in_my_heap = new int[v_num + 1];
-    my_heap_count = 0;
+    if ((int)dscore.size() < v_num + 1) {
+        dscore.resize(v_num + 1);
+        time_stamp.resize(v_num + 1);
+        v_offset.resize(v_num + 2);
+        v_edge_count.resize(v_num + 1);
+        v_in_c.resize(v_num + 1);
+        remove_cand.resize(v_num + 1);
+        index_in_remove_cand.resize(v_num + 1);
+        best_v_in_c.resize(v_num + 1);
+        conf_change.resize(v_num + 1);
+        bucket_next.resize(v_num + 1);
+        bucket_prev.resize(v_num + 1);
+    }
+    reset_state();
 
     for (int v = 1; v <= v_num; v++)
         v_edge_count[v] = 0;
@@ -118,30 +76,23 @@ void NumvcSolver::allocate_memory() {
 
 // Private helper function: build adjacency structure
 void NumvcSolver::build_adjacency() {
-    for (int v = 1; v <= v_num; v++) {
-        v_adj[v] = new int[v_edge_count[v]];
-        v_edges[v] = new int[v_edge_count[v]];
-    }
-
-    int* v_edge_count_tmp = new int[v_num + 1];
+    v_offset[1] = 0;
     for (int v = 1; v <= v_num; v++)
-        v_edge_count_tmp[v] = 0;
+        v_offset[v + 1] = v_offset[v] + v_edge_count[v];
 
+    // fill by advancing the offsets, then restore them
     for (int e = 0; e < e_num; e++) {
         int v1 = edge[e].v1;
         int v2 = edge[e].v2;
 
-        v_edges[v1][v_edge_count_tmp[v1]] = e;
-        v_edges[v2][v_edge_count_tmp[v2]] = e;
-
-        v_adj[v1][v_edge_count_tmp[v1]] = v2;
-        v_adj[v2][v_edge_count_tmp[v2]] = v1;
+        v_edges[v_offset[v1]] = e;
+        v_adj[v_offset[v1]++] = v2;
 
-        v_edge_count_tmp[v1]++;
-        v_edge_count_tmp[v2]++;
+        v_edges[v_offset[v2]] = e;
+        v_adj[v_offset[v2]++] = v1;
     }
-
-    delete[] v_edge_count_tmp;
+    for (int v = 1; v <= v_num; v++)
+        v_offset[v] -= v_edge_count[v];
 }
 
 int NumvcSolver::build_instance(char *filename) {
@@ -203,26 +154,8 @@ int NumvcSolver::build_instance_from_edges(const std::vector<std::pair<int, int>
 }
 
 void NumvcSolver::free_memory() {
-    for (int v = 1; v <= v_num; v++) {
-        delete[] v_adj[v];
-        delete[] v_edges[v];
-    }
-    delete[] conf_change;
-    delete[] best_v_in_c;
-    delete[] index_in_remove_cand;
-    delete[] remove_cand;
-    delete[] v_in_c;
-    delete[] v_edge_count;
-    delete[] v_adj;
-    delete[] v_edges;
-    delete[] time_stamp;
-    delete[] dscore;
-    delete[] index_in_uncov_stack;
-    delete[] uncov_stack;
-    delete[] edge_weight;
-    delete[] edge;
-    delete[] my_heap;
-    delete[] pos_in_my_heap;
+    // release the buffers, a reused solver keeps them instead
+    *this = NumvcSolver();
 }
 
 void NumvcSolver::reset_remove_cand() {
@@ -271,10 +204,7 @@ void NumvcSolver::update_best_cov_v() {
 }
 
 inline void NumvcSolver::uncover(int e) {
-    if (e < 0 || e >= e_num) {
-    std::cerr << "ERROR: uncover() called with invalid edge index: " << e << std::endl;
-    std::abort();
-    }
+    assert(e >= 0 && e < e_num);
     if (index_in_uncov_stack[e] >= 0) {
         return;
     }
@@ -283,28 +213,16 @@ inline void NumvcSolver::uncover(int e) {
 }
 
 inline void NumvcSolver::cover(int e) {
-    if (e < 0 || e >= e_num) {
-    std::cerr << "ERROR: cover() called with invalid edge index: " << e
-                << " (e_num=" << e_num << ")" << std::endl;
-    std::abort();
-    }
+    assert(e >= 0 && e < e_num);
 
-    // 检查：确保这条边 *确实* 是未覆盖的
+    // the edge must be uncovered
     int index = index_in_uncov_stack[e];
-    if (index < 0 || index >= uncov_stack_fill_pointer) { // 严格检查
-        fprintf(stderr, "FATAL: index_in_uncov_stack[%d] = %d is out of bounds (stack size = %d)\n",
-                e, index, uncov_stack_fill_pointer);
-        std::abort();
-    }
+    assert(index >= 0 && index < uncov_stack_fill_pointer);
 
     int last_uncov_edge = numvc_pop(uncov_stack); // Macro uses uncov_stack_fill_pointer member
-    // 如果弹出的边恰好是我们要覆盖的边，我们什么都不用做
-    // (除了在函数末尾将 e 的索引设为 -1)
+    // nothing to move when the popped one is e itself
     if (e != last_uncov_edge) {
-        if (last_uncov_edge < 0 || last_uncov_edge >= e_num) {
-            fprintf(stderr, "FATAL: popped invalid edge %d from uncov_stack\n", last_uncov_edge);
-            std::abort();
-        }
+        assert(last_uncov_edge >= 0 && last_uncov_edge < e_num);
         uncov_stack[index] = last_uncov_edge;
         index_in_uncov_stack[last_uncov_edge] = index;
     }
@@ -329,18 +247,23 @@ void NumvcSolver::init_sol() {
     for (int e = 0; e < e_num; e++)
         uncover(e);
 
+    int d_max = 0;
     for (int v = 1; v <= v_num; v++)
-        my_heap_insert(v);
+        d_max = std::max(d_max, dscore[v]);
+    bucket_head.assign(d_max + 1, 0);
+    for (int v = 1; v <= v_num; v++)
+        bucket_insert(v);
 
+    // greedy, dscore only decreases while constructing
     int i = 0;
+    int d = d_max;
     while (uncov_stack_fill_pointer > 0) {
-        int best_v = my_heap[0];
-        if (dscore[best_v] > 0) {
-            add_init(best_v);
-            i++;
-        } else {
+        while (d > 0 && bucket_head[d] == 0)
+            d--;
+        if (d == 0)
             break;
-        }
+        add_init(bucket_head[d]);
+        i++;
     }
 
     c_size = i;
@@ -349,14 +272,87 @@ void NumvcSolver::init_sol() {
     update_best_cov_v();
 }
 
+// initial solution from a given cover, e.g., of a similar graph
+void NumvcSolver::init_sol_from_cover(const std::vector<int>& cover) {
+    for (int v = 1; v <= v_num; v++) {
+        v_in_c[v] = 0;
+        dscore[v] = 0;
+        conf_change[v] = 1;
+        time_stamp[v] = 0;
+    }
+    for (int v : cover) {
+        if (v >= 0 && v < v_num) v_in_c[v + 1] = 1;
+    }
+
+    // repair, cover new edges by the endpoint with larger degree
+    for (int e = 0; e < e_num; e++) {
+        edge_weight[e] = 1;
+        int v1 = edge[e].v1;
+        int v2 = edge[e].v2;
+        if (v_in_c[v1] == 1 || v_in_c[v2] == 1)
+            continue;
+        if (v_edge_count[v1] >= v_edge_count[v2])
+            v_in_c[v1] = 1;
+        else
+            v_in_c[v2] = 1;
+    }
+
+    // drop redundant vertices, e.g., left by deleted edges
+    c_size = 0;
+    for (int v = 1; v <= v_num; v++) {
+        if (v_in_c[v] == 0)
+            continue;
+        bool redundant = true;
+        for (int k = v_offset[v]; k < v_offset[v + 1]; ++k) {
+            if (v_in_c[v_adj[k]] == 0) {
+                redundant = false;
+                break;
+            }
+        }
+        if (redundant)
+            v_in_c[v] = 0;
+        else
+            c_size++;
+    }
+
+    // all edges are covered, dscore is the loss of removal
+    uncov_stack_fill_pointer = 0;
+    for (int e = 0; e < e_num; e++) {
+        int v1 = edge[e].v1;
+        int v2 = edge[e].v2;
+        if (v_in_c[v1] + v_in_c[v2] == 1) {
+            dscore[v_in_c[v1] == 1 ? v1 : v2] -= edge_weight[e];
+        }
+    }
+
+    update_best_sol();
+    reset_remove_cand();
+    update_best_cov_v();
+}
+
+// lower bound of the cover size, by a greedy maximal matching
+int NumvcSolver::get_matching_size() {
+    for (int v = 1; v <= v_num; v++)
+        conf_change[v] = 0;
+    int size = 0;
+    for (int e = 0; e < e_num; e++) {
+        int v1 = edge[e].v1;
+        int v2 = edge[e].v2;
+        if (v1 == v2 || conf_change[v1] == 1 || conf_change[v2] == 1)
+            continue;
+        conf_change[v1] = conf_change[v2] = 1;
+        size++;
+    }
+    return size;
+}
+
 void NumvcSolver::add(int v) {
     v_in_c[v] = 1;
     dscore[v] = -dscore[v];
 
-    int edge_count = v_edge_count[v];
-    for (int i = 0; i < edge_count; ++i) {
-        int e = v_edges[v][i];
-        int n = v_adj[v][i];
+    for (int k = v_offset[v]; k < v_offset[v + 1]; ++k) {
+        int e = v_edges[k];
+        int n = v_adj[k];
 
         if (v_in_c[n] == 0) {
             dscore[n] -= edge_weight[e];
@@ -369,25 +365,21 @@ void NumvcSolver::add(int v) {
 }
 
 void NumvcSolver::add_init(int v) {
-    int pos = pos_in_my_heap[v];
-    my_heap_remove(pos);
+    bucket_remove(v);
 
     v_in_c[v] = 1;
     dscore[v] = -dscore[v];
 
-    int edge_count = v_edge_count[v];
-    for (int i = 0; i < edge_count; ++i) {
-        int e = v_edges[v][i];
-        int n = v_adj[v][i];
+    for (int k = v_offset[v]; k < v_offset[v + 1]; ++k) {
+        int e = v_edges[k];
+        int n = v_adj[k];
 
         if (v_in_c[n] == 0) {
+            bucket_remove(n);
             dscore[n] -= edge_weight[e];
+            bucket_insert(n);
             conf_change[n] = 1;
 
-            pos = pos_in_my_heap[n];
-            my_heap_remove(pos);
-            my_heap_insert(n);
-
             cover(e);
         } else {
             dscore[n] += edge_weight[e];
@@ -400,10 +392,9 @@ void NumvcSolver::remove(int v) {
     dscore[v] = -dscore[v];
     conf_change[v] = 0;
 
-    int edge_count = v_edge_count[v];
-    for (int i = 0; i < edge_count; ++i) {
-        int e = v_edges[v][i];
-        int n = v_adj[v][i];
+    for (int k = v_offset[v]; k < v_offset[v + 1]; ++k) {
+        int e = v_edges[k];
+        int n = v_adj[k];
 
         if (v_in_c[n] == 0) {
             dscore[n] += edge_weight[e];
@@ -485,7 +476,10 @@ void NumvcSolver::cover_LS() {
             continue;
         }
 
-        if (step % try_step == 0) {
+        if (step >= max_steps)
+            return;
+
+        if (step % clock_check_steps == 0) {
             auto current_time = high_resolution_clock::now();
             auto elapsed_duration = duration_cast<microseconds>(current_time - start_time_hr);
             double elap_time = elapsed_duration.count() / 1000000.0;
@@ -529,56 +523,77 @@ void NumvcSolver::cover_LS() {
     }
 }
 
-// Public API implementations
-MVCResult numvc_solve_mvc(const std::vector<std::pair<int, int>>& edges,
-                   int vertex_count, int optimal_size,
-                   double cutoff_time, int random_seed) {
-
+MVCResult NumvcSolver::solve(const std::vector<std::pair<int, int>>& edges,
+                             int vertex_count, int _optimal_size,
+                             double _cutoff_time, int random_seed,
+                             const std::vector<int>* init_cover,
+                             long long _max_steps) {
     MVCResult result;
     result.success = false;
-    if(edges.empty() || vertex_count <= 0) {
+    if (edges.empty() || vertex_count <= 0) {
         result.success = true;
         result.mvc_size = 0;
         result.solve_time = 0.0;
         result.steps = 0;
         return result;
     }
-    NumvcSolver solver;
-    solver.optimal_size = optimal_size;
-    solver.cutoff_time = cutoff_time;
-    solver.threshold = vertex_count / 2;
+    cutoff_time = _cutoff_time;
+    max_steps = (_max_steps > 0) ? _max_steps : LLONG_MAX;
+    clock_check_steps = (_max_steps > 0) ? NUMVC_CLOCK_CHECK_STEPS : try_step;
+    threshold = vertex_count / 2;
 
-    solver.rng.seed(random_seed);
+    rng.seed(random_seed);
 
-    if (solver.build_instance_from_edges(edges, vertex_count) != 1) {
+    if (build_instance_from_edges(edges, vertex_count) != 1) {
         return result;
     }
 
-    solver.start_time_hr = high_resolution_clock::now();
+    // the search stops as soon as it meets the lower bound
+    optimal_size = std::max(_optimal_size, get_matching_size());
 
-    solver.init_sol();
+    start_time_hr = high_resolution_clock::now();
 
-    if (solver.c_size + solver.uncov_stack_fill_pointer > optimal_size) {
-        solver.cover_LS();
+    if (init_cover != nullptr)
+        init_sol_from_cover(*init_cover);
+    else
+        init_sol();
+
+    if (c_size + uncov_stack_fill_pointer > optimal_size) {
+        cover_LS();
     }
 
-    if (solver.check_solution() == 1) {
+    if (check_solution() == 1) {
         result.success = true;
-        result.mvc_size = solver.best_c_size;
-        result.solve_time = solver.best_comp_time;
-        result.steps = solver.best_step;
-
-        // for (int i = 1; i <= solver.v_num; i++) {
-        //     if (solver.best_v_in_c[i] == 1) {
-        //         result.mvc.push_back(i);
-        //     }
-        // }
+        result.mvc_size = best_c_size;
+        result.solve_time = best_comp_time;
+        result.steps = best_step;
+
+        for (int i = 1; i <= v_num; i++) {
+            if (best_v_in_c[i] == 1) {
+                result.mvc.push_back(i - 1);
+            }
+        }
     }
-
-    solver.free_memory();
     return result;
 }
 
+// Public API implementations
+static thread_local NumvcSolver *bound_solver = nullptr;
+
+void numvc_bind_solver(NumvcSolver *solver) {
+    bound_solver = solver;
+}
+
+MVCResult numvc_solve_mvc(const std::vector<std::pair<int, int>>& edges,
+                   int vertex_count, int optimal_size,
+                   double cutoff_time, int random_seed,
+                   const std::vector<int>* init_cover, long long max_steps) {
+    static thread_local NumvcSolver thread_solver;
+    auto solver = (bound_solver != nullptr) ? bound_solver : &thread_solver;
+    return solver->solve(edges, vertex_count, optimal_size, cutoff_time,
+                         random_seed, init_cover, max_steps);
+}
+
 MVCResult solve_mvc_from_file(const char* filename, int optimal_size,
                              double cutoff_time, int random_seed) {
 
@@ -588,6 +603,8 @@ MVCResult solve_mvc_from_file(const char* filename, int optimal_size,
     NumvcSolver solver;
     solver.optimal_size = optimal_size;
     solver.cutoff_time = cutoff_time;
+    solver.max_steps = LLONG_MAX;
+    solver.clock_check_steps = try_step;
 
     solver.rng.seed(random_seed);
 
@@ -611,11 +628,11 @@ MVCResult solve_mvc_from_file(const char* filename, int optimal_size,
         result.solve_time = solver.best_comp_time;
         result.steps = solver.best_step;
 
-        // for (int i = 1; i <= solver.v_num; i++) {
-        //     if (solver.best_v_in_c[i] == 1) {
-        //         result.mvc.push_back(i);
-        //     }
-        // }
+        for (int i = 1; i <= solver.v_num; i++) {
+            if (solver.best_v_in_c[i] == 1) {
+                result.mvc.push_back(i - 1);
+            }
+        }
     }
 
     solver.free_memory();
@@ -10,10 +10,24 @@
 #include <cmath>
 #include <algorithm>
 #include <random>
+#include <climits>
+#include <cassert>
 
 using namespace std;
 using namespace std::chrono;
 
+// step budget of the local search, reproducible unlike a wall-clock cutoff
+constexpr long long NUMVC_MIN_STEPS = 1000;
+constexpr long long NUMVC_STEPS_PER_EDGE = 5;
+// with a step budget, the clock is checked every this steps as a guard
+constexpr long long NUMVC_CLOCK_CHECK_STEPS = 1000;
+// coarse wall-clock guard (seconds) of step-budgeted searches
+constexpr double NUMVC_CLOCK_GUARD = 0.005;
+
+inline long long numvc_step_budget(int num_edges) {
+    return std::max(NUMVC_MIN_STEPS, NUMVC_STEPS_PER_EDGE * num_edges);
+}
+
 #define numvc_pop(stack) stack[--stack##_fill_pointer]
 #define numvc_push(item, stack) stack[stack##_fill_pointer++] = item
 
@@ -24,7 +38,7 @@ struct Edge {
 
 struct MVCResult {
     int mvc_size;
-    // std::vector<int> mvc;
+    std::vector<int> mvc;  // vertices of the cover, 0-indexed
     double solve_time;
     int steps;
     bool success;
@@ -37,8 +51,9 @@ public:
     high_resolution_clock::time_point finish_time_hr;
 
     // parameters of algorithm
-    long long max_steps;
+    long long max_steps;          // LLONG_MAX -> only the cutoff time
     double cutoff_time;
+    long long clock_check_steps;  // interval of checking the cutoff time
     long long step;
     int optimal_size;
 
@@ -46,40 +61,45 @@ public:
     int v_num;
     int e_num;
 
+    // buffers below keep their capacity across solves, only the used
+    // prefix ([0, e_num) for edges, [1, v_num] for vertices) is reset
+
     // structures about edge
-    Edge *edge;
-    int *edge_weight;
+    std::vector<Edge> edge;
+    std::vector<int> edge_weight;
 
     // structures about vertex
-    int *dscore;
-    long long *time_stamp;
+    std::vector<int> dscore;
+    std::vector<long long> time_stamp;
     int best_cov_v;
 
-    // from vertex to it's edges and neighbors
-    int **v_edges;
-    int **v_adj;
-    int *v_edge_count;
+    // from vertex to it's edges and neighbors, in CSR layout,
+    // those of v are in [v_offset[v], v_offset[v + 1])
+    std::vector<int> v_offset;
+    std::vector<int> v_edges;
+    std::vector<int> v_adj;
+    std::vector<int> v_edge_count;
 
     // structures about solution
     int c_size;
-    int *v_in_c;
-    int *remove_cand;
-    int *index_in_remove_cand;
+    std::vector<int> v_in_c;
+    std::vector<int> remove_cand;
+    std::vector<int> index_in_remove_cand;
     int remove_cand_size;
 
     // best solution found
     int best_c_size;
-    int *best_v_in_c;
+    std::vector<int> best_v_in_c;
     double best_comp_time;
     long best_step;
 
     // uncovered edge stack
-    int *uncov_stack;
+    std::vector<int> uncov_stack;
     int uncov_stack_fill_pointer;
-    int *index_in_uncov_stack;
+    std::vector<int> index_in_uncov_stack;
 
     // CC and taboo
-    int *conf_change;
+    std::vector<int> conf_change;
     int tabu_remove;
 
     // smooth
@@ -88,29 +108,36 @@ public:
     int threshold;
     float p_scale;
 
-    // heap
-    int *my_heap;
-    int *pos_in_my_heap;
-    int my_heap_count;
+    // bucket queue of greedy construction, by dscore, 0 -> none
+    std::vector<int> bucket_head;
+    std::vector<int> bucket_next;
+    std::vector<int> bucket_prev;
 
     std::mt19937 rng;
 
     // constructor
-    NumvcSolver() : tabu_remove(0), ave_weight(1), delta_total_weight(0),
-                    p_scale(0.3f), my_heap_count(0), uncov_stack_fill_pointer(0),
-                    edge(nullptr), edge_weight(nullptr), dscore(nullptr), time_stamp(nullptr),
-                    v_edges(nullptr), v_adj(nullptr), v_edge_count(nullptr), v_in_c(nullptr),
-                    remove_cand(nullptr), index_in_remove_cand(nullptr), best_v_in_c(nullptr),
-                    conf_change(nullptr), uncov_stack(nullptr), index_in_uncov_stack(nullptr),
-                    my_heap(nullptr), pos_in_my_heap(nullptr) {
+    NumvcSolver() : v_num(0), e_num(0), uncov_stack_fill_pointer(0),
+                    tabu_remove(0), ave_weight(1), delta_total_weight(0),
+                    p_scale(0.3f) {
         start_time_hr = high_resolution_clock::now();
         finish_time_hr = high_resolution_clock::now();
     }
 
+    // solve with the buffers of previous calls, the solver can be reused
+    // init_cover (0-indexed) is repaired and used instead of the greedy one
+    // max_steps > 0 -> stop after the steps, cutoff_time is a coarse guard
+    MVCResult solve(const std::vector<std::pair<int, int>>& edges,
+                    int vertex_count, int optimal_size, double cutoff_time,
+                    int random_seed,
+                    const std::vector<int>* init_cover = nullptr,
+                    long long max_steps = 0);
+
     // Member functions (previously took NumvcSolver* as first parameter)
     int build_instance(char *filename);
     int build_instance_from_edges(const std::vector<std::pair<int, int>>& edges, int vertex_count);
     void init_sol();
+    void init_sol_from_cover(const std::vector<int>& cover);
+    int get_matching_size();
     void cover_LS();
     void add(int v);
     void add_init(int v);
@@ -126,37 +153,32 @@ public:
     void uncover(int e);
     void cover(int e);
 
-    // Heap functions
-    void my_heap_swap(int a, int b);
-    bool my_heap_is_leaf(int pos);
-    void my_heap_shiftdown(int pos);
-    void my_heap_insert(int v);
-    int my_heap_remove_first();
-    int my_heap_remove(int pos);
 private:
+    void reset_state();
     void allocate_memory();
     void build_adjacency();
+    void bucket_insert(int v);
+    void bucket_remove(int v);
 };
 
-// Static helper functions (don't need solver instance)
-int my_heap_left_child(int pos);
-int my_heap_right_child(int pos);
-int my_heap_parent(int pos);
-
 // Public API
+// bind the solver used by numvc_solve_mvc on the calling thread, e.g., one
+// per planner worker; nullptr -> a solver owned by the thread
+void numvc_bind_solver(NumvcSolver *solver);
+
 MVCResult numvc_solve_mvc(const std::vector<std::pair<int, int>>& edges,
                         int vertex_count,
                         int optimal_size = 0,
                         double cutoff_time = 10.0,
-                        int random_seed = 1);
+                        int random_seed = 1,
+                        const std::vector<int>* init_cover = nullptr,
+                        long long max_steps = 0);
 
 MVCResult solve_mvc_from_file(const char* filename,
                              int optimal_size = 0,
                              double cutoff_time = 10.0,
                              int random_seed = 1);
 
-inline int numvc(const std::vector<std::pair<int, int>>& edges, int vertex_count){
-    auto result= numvc_solve_mvc(edges, vertex_count, 0, 0.0005, 1);
-    return result.mvc_size;
-}
+// minimum vertex cover size, exact on small kernels (see mvc_kernel.h)
+int numvc(const std::vector<std::pair<int, int>>& edges, int vertex_count);
 #endif
@@ -0,0 +1,69 @@
+/*
+ * throughput of CollisionTable, i.e., enroll / clear / query
+ * usage: bench_collision_table [map] [number of agents] [path length]
+ */
+#include <lacam.hpp>
+
+int main(int argc, char *argv[])
+{
+  const std::string map_filename =
+      argc > 1 ? argv[1] : "../assets/random-32-32-10.map";
+  const auto N = argc > 2 ? std::stoi(argv[2]) : 400;
+  const auto T = argc > 3 ? std::stoi(argv[3]) : 200;
+  const auto ins = Instance(map_filename, N, 0);
+  if (!ins.is_valid(1)) return 1;
+
+  // random walks
+  auto MT = std::mt19937(0);
+  auto paths = Paths(N);
+  for (auto i = 0; i < N; ++i) {
+    auto v = ins.starts[i];
+    paths[i].push_back(v);
+    for (auto t = 1; t <= T; ++t) {
+      auto &&C = v->neighbor;
+      if (!C.empty()) v = C[get_random_int(MT, 0, C.size() - 1)];
+      paths[i].push_back(v);
+    }
+  }
+  auto queries = std::vector<std::tuple<Vertex *, Vertex *, int>>();
+  for (auto k = 0; k < N * T; ++k) {
+    auto v = ins.G->V[get_random_int(MT, 0, ins.G->size() - 1)];
+    if (v->neighbor.empty()) continue;
+    auto u = v->neighbor[get_random_int(MT, 0, v->neighbor.size() - 1)];
+    queries.emplace_back(v, u, get_random_int(MT, 0, T + 10));
+  }
+
+  const auto repetitions = 10;
+  auto measure = [](auto &&f) {
+    const auto deadline = Deadline();
+    f();
+    return deadline.elapsed_ns();
+  };
+  auto CT = CollisionTable(&ins);
+  double t_enroll = 0, t_query = 0, t_clear = 0;
+  long long checksum = 0;
+  for (auto r = 0; r < repetitions; ++r) {
+    t_enroll += measure([&]() {
+      for (auto i = 0; i < N; ++i) CT.enrollPath(i, paths[i]);
+    });
+    t_query += measure([&]() {
+      for (auto &&q : queries) {
+        checksum += CT.getCollisionCost(std::get<0>(q), std::get<1>(q),
+                                        std::get<2>(q));
+      }
+    });
+    checksum += CT.collision_cnt;
+    t_clear += measure([&]() {
+      for (auto i = 0; i < N; ++i) CT.clearPath(i, paths[i]);
+    });
+  }
+
+  const double steps = (double)repetitions * N * (T + 1);
+  std::cout << "map=" << map_filename << " N=" << N << " T=" << T
+            << " checksum=" << checksum << std::endl;
+  std::cout << "enroll_ns_per_step=" << t_enroll / steps << std::endl;
+  std::cout << "clear_ns_per_step=" << t_clear / steps << std::endl;
+  std::cout << "query_ns=" << t_query / (repetitions * queries.size())
+            << std::endl;
+  return 0;
+}
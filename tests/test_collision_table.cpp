@@ -0,0 +1,121 @@
+#include <cassert>
+#include <lacam.hpp>
+
+int main()
+{
+  {
+    const auto map_filename = "../tests/assets/sapp2.map";
+    const auto ins = Instance(map_filename, std::vector<int>({0, 2, 4, 5, 7, 3}),
+                              std::vector<int>({2, 0, 5, 4, 7, 6}));
+    auto &V = ins.G->V;
+    auto CT = CollisionTable(&ins);
+    auto colliding = std::vector<int>();
+
+    // vertex collision
+    auto path0 = Path({V[0], V[1], V[2]});
+    auto path1 = Path({V[2], V[1], V[0]});
+    CT.enrollPath(0, path0);
+    CT.enrollPath(1, path1);
+    assert(CT.collision_cnt == 1);
+    assert(CT.getCollisionCost(V[0], V[1], 0) == 2);
+    CT.getCollidingAgents(0, path0, colliding);
+    assert(colliding == std::vector<int>({1}));
+
+    // edge collision
+    auto path2 = Path({V[4], V[5]});
+    auto path3 = Path({V[5], V[4]});
+    CT.enrollPath(2, path2);
+    CT.enrollPath(3, path3);
+    assert(CT.collision_cnt == 2);
+    colliding.clear();
+    CT.getCollidingAgents(2, path2, colliding);
+    assert(colliding == std::vector<int>({3}));
+
+    // goal collision
+    auto path4 = Path({V[7]});
+    auto path5 = Path({V[3], V[7], V[6]});
+    CT.enrollPath(4, path4);
+    CT.enrollPath(5, path5);
+    assert(CT.collision_cnt == 3);
+    colliding.clear();
+    CT.getCollidingAgents(4, path4, colliding);
+    assert(colliding == std::vector<int>({5}));
+    colliding.clear();
+    CT.getCollidingAgents(5, path5, colliding);
+    assert(colliding == std::vector<int>({4}));
+
+    // earliest / latest departure
+    assert(CT.getEarliestFreeMove(0, 1, 0, 5) == 2);
+    assert(CT.getLatestFreeMove(0, 1, 0, 1) == -1);
+    assert(CT.getEarliestFreeMove(6, 7, 0, 10) == INT_MAX);
+    for (auto &&u : V) {
+      for (auto &&v : V) {
+        for (auto t_lo = 0; t_lo <= 4; ++t_lo) {
+          for (auto t_hi = t_lo; t_hi <= 5; ++t_hi) {
+            auto t_earliest = INT_MAX;
+            auto t_latest = -1;
+            for (auto t = t_lo; t <= t_hi; ++t) {
+              if (CT.getCollisionCost(u, v, t) > 0) continue;
+              t_earliest = std::min(t_earliest, t);
+              t_latest = t;
+            }
+            assert(CT.getEarliestFreeMove(u->id, v->id, t_lo, t_hi) ==
+                   t_earliest);
+            assert(CT.getLatestFreeMove(u->id, v->id, t_lo, t_hi) == t_latest);
+          }
+        }
+      }
+    }
+
+    // clear
+    CT.clearPath(0, path0);
+    CT.clearPath(1, path1);
+    CT.clearPath(2, path2);
+    CT.clearPath(3, path3);
+    CT.clearPath(4, path4);
+    CT.clearPath(5, path5);
+    assert(CT.collision_cnt == 0);
+    assert(CT.getCollisionCost(V[0], V[1], 0) == 0);
+  }
+
+  // copy-on-write overlay
+  {
+    const auto map_filename = "../tests/assets/sapp2.map";
+    const auto ins = Instance(map_filename, std::vector<int>({0, 2, 4, 5}),
+                              std::vector<int>({2, 0, 5, 4}));
+    auto &V = ins.G->V;
+    auto paths = Paths({Path({V[0], V[1], V[2]}), Path({V[2], V[1], V[0]}),
+                        Path({V[4], V[5]}), Path({V[5], V[4]})});
+    auto CT_base = CollisionTable(&ins);
+    auto CT = CollisionTable(&ins);
+    for (auto i = 0; i < 4; ++i) {
+      CT_base.enrollPath(i, paths[i]);
+      CT.enrollPath(i, paths[i]);
+    }
+    auto CT_overlay = CollisionTable(&CT_base, true);
+    auto path = Path({V[0], V[1], V[1], V[2]});
+    for (auto _CT : {&CT, &CT_overlay}) {
+      _CT->clearPath(0, paths[0]);
+      _CT->clearPath(2, paths[2]);
+      _CT->enrollPath(0, path);
+    }
+    assert(CT_overlay.collision_cnt == CT.collision_cnt);
+    for (auto &&u : V) {
+      for (auto &&v : V) {
+        for (auto t = 0; t <= 5; ++t) {
+          assert(CT_overlay.getCollisionCost(u, v, t) ==
+                 CT.getCollisionCost(u, v, t));
+        }
+      }
+      assert(CT_overlay.getGoalTime(u->id) == CT.getGoalTime(u->id));
+    }
+    auto colliding = std::vector<int>();
+    CT_overlay.getCollidingAgents(0, path, colliding);
+    assert(colliding == std::vector<int>({1}));
+    // the base is untouched
+    assert(CT_base.getOccupancy(V[5]->id, 1) == 1);
+    assert(CT_overlay.getOccupancy(V[5]->id, 1) == 0);
+  }
+
+  return 0;
+}
@@ -14,5 +14,23 @@ int main()
     assert(G.height == 32);
   }
 
+  {
+    const std::string filename = "../tests/assets/sapp.map";
+    auto G = Graph(filename);
+    assert(G.corridors.size() == 1);
+    assert(G.corridors[0] == Vertices({G.V[2]}));
+    assert(G.V[2]->corridor_id == 0);
+    assert(G.V[1]->corridor_id == -1);
+    assert(G.V[3]->corridor_id == -1);
+  }
+
+  {
+    const std::string filename = "../tests/assets/sapp2.map";
+    auto G = Graph(filename);
+    assert(G.corridors.size() == 2);  // left and right columns
+    assert(G.corridors[0] == Vertices({G.V[0], G.V[4]}));
+    assert(G.V[4]->corridor_pos == 1);
+  }
+
   return 0;
 }
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cassert>
+#include <random>
+
+#include "mvc_kernel.h"
+
+// minimum vertex cover by enumeration
+int brute_force_mvc(const std::vector<std::pair<int, int>> &edges, int n)
+{
+  auto best = n;
+  for (auto S = 0; S < (1 << n); ++S) {
+    auto flg_cover = true;
+    for (auto &&e : edges) {
+      if (!((S >> e.first) & 1) && !((S >> e.second) & 1)) {
+        flg_cover = false;
+        break;
+      }
+    }
+    if (flg_cover) best = std::min(best, __builtin_popcount(S));
+  }
+  return best;
+}
+
+int main()
+{
+  // closed forms
+  {
+    auto path = std::vector<std::pair<int, int>>({{0, 1}, {1, 2}, {2, 3}});
+    assert(mvc_solve(path, 4) == 2);
+    auto cycle = std::vector<std::pair<int, int>>({{0, 1}, {1, 2}, {2, 0}});
+    assert(mvc_solve(cycle, 3) == 2);
+    auto star = std::vector<std::pair<int, int>>({{0, 1}, {0, 2}, {0, 3}});
+    assert(mvc_solve(star, 4) == 1);
+    auto edge = std::vector<std::pair<int, int>>({{3, 5}, {5, 3}});
+    assert(mvc_solve(edge, 8) == 1);
+    assert(numvc(edge, 8) == 1);
+  }
+
+  // random graphs, sparse ones exercise reductions, dense ones the search
+  {
+    auto MT = std::mt19937(0);
+    for (auto k = 0; k < 300; ++k) {
+      const auto n = 4 + k % 13;
+      const auto m = (k % 3 + 1) * n;
+      auto edges = std::vector<std::pair<int, int>>();
+      for (auto j = 0; j < m; ++j) {
+        edges.emplace_back(MT() % n, MT() % n);
+        if (edges.back().first == edges.back().second) edges.pop_back();
+      }
+      assert(mvc_solve(edges, n) == brute_force_mvc(edges, n));
+    }
+  }
+
+  // disjoint components, larger than a single exact search in total
+  {
+    auto MT = std::mt19937(1);
+    const auto n = 12;
+    auto edges = std::vector<std::pair<int, int>>();
+    for (auto j = 0; j < 2 * n; ++j) {
+      edges.emplace_back(MT() % n, MT() % n);
+      if (edges.back().first == edges.back().second) edges.pop_back();
+    }
+    const auto num_copies = 10;
+    auto edges_all = std::vector<std::pair<int, int>>();
+    for (auto c = 0; c < num_copies; ++c) {
+      for (auto &&e : edges) {
+        edges_all.emplace_back(c * n + e.first, c * n + e.second);
+      }
+    }
+    assert(mvc_solve(edges_all, num_copies * n) ==
+           num_copies * brute_force_mvc(edges, n));
+  }
+
+  // step-budgeted local search, reproducible
+  {
+    auto MT = std::mt19937(2);
+    const auto n = 300;
+    auto edges = std::vector<std::pair<int, int>>();
+    for (auto j = 0; j < 3 * n; ++j) {
+      edges.emplace_back(MT() % n, MT() % n);
+      if (edges.back().first == edges.back().second) edges.pop_back();
+    }
+    const auto max_steps = numvc_step_budget(edges.size());
+    auto res1 = numvc_solve_mvc(edges, n, 0, 10.0, 1, nullptr, max_steps);
+    auto res2 = numvc_solve_mvc(edges, n, 0, 10.0, 1, nullptr, max_steps);
+    assert(res1.success && res2.success);
+    assert(res1.mvc == res2.mvc);
+    assert(res1.steps <= max_steps);
+  }
+
+  // cache, keyed by components with agent ids
+  {
+    mvc_cache_clear();
+    auto edges = std::vector<std::pair<int, int>>();
+    for (auto i = 0; i < 10; ++i) edges.emplace_back(i, (i + 1) % 10);
+    for (auto i = 0; i < 10; ++i) edges.emplace_back(i, (i + 3) % 10);
+    const auto size = mvc_solve(edges, 20);
+    assert(mvc_cache_get_hits() == 0 && mvc_cache_get_misses() == 1);
+    std::reverse(edges.begin(), edges.end());
+    assert(mvc_solve(edges, 20) == size);
+    assert(mvc_cache_get_hits() == 1);
+    // the same shape with other agents is another entry
+    for (auto &&e : edges) e = {e.first + 10, e.second + 10};
+    assert(mvc_solve(edges, 20) == size);
+    assert(mvc_cache_get_hits() == 1 && mvc_cache_get_misses() == 2);
+  }
+
+  // warm start, numvc repairs the cover of a similar graph, by agent ids
+  {
+    auto MT = std::mt19937(3);
+    const auto n = 300;
+    auto edges = std::vector<std::pair<int, int>>();
+    for (auto j = 0; j < 3 * n; ++j) {
+      edges.emplace_back(MT() % n, MT() % n);
+      if (edges.back().first == edges.back().second) edges.pop_back();
+    }
+    auto solver = NumvcSolver();
+    numvc_bind_solver(&solver);
+    auto cover = std::vector<int>();
+    mvc_bind_cover(nullptr, &cover);
+    mvc_solve(edges, n);
+    assert(!cover.empty());
+    for (auto v : cover) assert(0 <= v && v < n);
+    // some agents move
+    for (auto j = 0; j < 20; ++j) edges[MT() % edges.size()].second = MT() % n;
+    mvc_cache_clear();
+    mvc_bind_cover(nullptr, nullptr);
+    const auto size_cold = mvc_solve(edges, n);
+    const auto steps_cold = solver.best_step;
+    mvc_cache_clear();
+    auto cover_warm = std::vector<int>();
+    mvc_bind_cover(&cover, &cover_warm);
+    const auto size_warm = mvc_solve(edges, n);
+    const auto steps_warm = solver.best_step;
+    mvc_bind_cover(nullptr, nullptr);
+    numvc_bind_solver(nullptr);
+    assert(!cover_warm.empty());
+    assert(size_warm <= size_cold);
+    assert(steps_warm < steps_cold);
+  }
+
+  return 0;
+}
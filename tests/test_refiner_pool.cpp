@@ -0,0 +1,33 @@
+#include <cassert>
+#include <lacam.hpp>
+
+int main()
+{
+  // failed refiners are reported, so the planner keeps replacing them
+  {
+    const auto num = Planner::REFINER_NUM;
+    auto pool = RefinerPool(num);
+    auto fail = [] { return RefinerResult{nullptr, nullptr, 0}; };
+    for (auto k = 0; k < num; ++k) pool.submit(fail);
+    auto completed = 0;
+    auto result = RefinerResult();
+    const auto deadline = Deadline(10000);
+    while (completed < 100 * num && !is_expired(&deadline)) {
+      while (pool.pop_finished(result)) {
+        assert(result.plan == nullptr);
+        ++completed;
+        pool.submit(fail);
+      }
+      {
+        std::lock_guard<std::mutex> lock(pool.mtx);
+        assert((int)(pool.jobs.size() + pool.finished.size()) +
+                   pool.num_running ==
+               num);
+      }
+      std::this_thread::yield();
+    }
+    assert(completed >= 100 * num);
+  }
+
+  return 0;
+}
@@ -0,0 +1,56 @@
+#include <cassert>
+#include <lacam.hpp>
+
+int main()
+{
+  {
+    const auto scen_filename = "../assets/random-32-32-10-random-1.scen";
+    const auto map_filename = "../assets/random-32-32-10.map";
+    const auto ins = Instance(scen_filename, map_filename, 50);
+    auto D = DistTable(ins);
+    auto scatter = Scatter(&ins, &D, nullptr, 0, 0, 2);
+    scatter.construct();
+
+    for (uint i = 0; i < ins.N; ++i) {
+      auto &path = scatter.paths[i];
+      assert(path.front() == ins.starts[i]);
+      assert(path.back() == ins.goals[i]);
+      assert(get_path_cost(path) <= D.get(i, ins.starts[i]) + 2);
+
+      // following the path
+      auto hint = 0;
+      for (auto t = 0; t + 1 < (int)path.size(); ++t) {
+        assert(scatter.get_next(i, path[t], hint) == path[t + 1]);
+        assert(hint == t);
+      }
+      assert(scatter.get_next(i, path.back(), hint) == nullptr);
+
+      // without hint
+      for (auto t = 0; t + 1 < (int)path.size(); ++t) {
+        hint = -1;
+        assert(scatter.get_next(i, path[t], hint) == path[t + 1]);
+      }
+    }
+  }
+
+  {
+    // parallel SUO
+    const auto scen_filename = "../assets/random-32-32-10-random-1.scen";
+    const auto map_filename = "../assets/random-32-32-10.map";
+    const auto ins = Instance(scen_filename, map_filename, 100);
+    auto D = DistTable(ins);
+    auto scatter = Scatter(&ins, &D, nullptr, 0, 0, 2, 4);
+    scatter.construct();
+
+    auto CT = CollisionTable(&ins);
+    for (uint i = 0; i < ins.N; ++i) {
+      auto &path = scatter.paths[i];
+      assert(path.front() == ins.starts[i]);
+      assert(path.back() == ins.goals[i]);
+      CT.enrollPath(i, path);
+    }
+    assert(CT.collision_cnt == scatter.CT.collision_cnt);
+  }
+
+  return 0;
+}
@@ -3,12 +3,12 @@
 
 int main()
 {
-  {
+  for (auto flg_safe_intervals : {false, true}) {
     const auto scen_filename = "../tests/assets/sapp.scen";
     const auto map_filename = "../tests/assets/sapp.map";
     const auto ins = Instance(scen_filename, map_filename, 1);
     auto D = DistTable(ins);
-    auto CT = CollisionTable(&ins);
+    auto CT = CollisionTable(&ins, flg_safe_intervals);
     const auto i = 0;
     auto path1 = sipp(i, ins.starts[i], ins.goals[i], &D, &CT);
     assert(path1 == Path({ins.G->V[0], ins.G->V[1], ins.G->V[2], ins.G->V[3]}));
@@ -30,12 +30,12 @@ int main()
                           ins.G->V[2], ins.G->V[3]}));
   }
 
-  {
+  for (auto flg_safe_intervals : {false, true}) {
     const auto scen_filename = "../tests/assets/sapp2.scen";
     const auto map_filename = "../tests/assets/sapp2.map";
     const auto ins = Instance(scen_filename, map_filename, 1);
     auto D = DistTable(ins);
-    auto CT = CollisionTable(&ins);
+    auto CT = CollisionTable(&ins, flg_safe_intervals);
     const auto i = 0;
     auto path1 = sipp(i, ins.starts[i], ins.goals[i], &D, &CT);
     assert(path1 == Path({ins.G->V[1]}));
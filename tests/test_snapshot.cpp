@@ -0,0 +1,39 @@
+#include <cassert>
+#include <lacam.hpp>
+
+int main()
+{
+  {
+    const auto map_filename = "../assets/empty-8-8.map";
+    const auto ins = Instance(map_filename, std::vector<int>({0, 8}),
+                              std::vector<int>({2, 1}));
+    auto &U = ins.G->U;
+    auto sol = Solution(4);
+    sol[0] = Config({U[0], U[8]});
+    sol[1] = Config({U[1], U[0]});
+    sol[2] = Config({U[2], U[0]});
+    sol[3] = Config({U[2], U[1]});
+
+    // paths are cut after reaching goals
+    auto S = Snapshot::from_configs(sol);
+    assert(S->T == 3);
+    assert(S->offsets == std::vector<int>({0, 3, 7}));
+    assert(S->get_vertex_id(0, 3) == U[2]->id);
+    assert(S->get_sum_of_loss() == get_sum_of_loss(sol));
+    assert(S->get_sum_of_loss(2) == 1);
+    assert(S->get_solution(ins.G) == sol);
+    assert(Snapshot::from_paths(S->get_paths(ins.G))->get_solution(ins.G) ==
+           sol);
+
+    // comparison of configurations
+    sol[2] = Config({U[1], U[0]});
+    sol[3] = Config({U[2], U[1]});
+    auto S2 = Snapshot::from_configs(sol);
+    assert(S2->is_same_config(1, *S, 1));
+    assert(!S2->is_same_config(2, *S, 2));
+    assert(S2->is_same_config(3, *S, 3));
+    assert(!S2->is_same_config(1, *S, 4));
+  }
+
+  return 0;
+}